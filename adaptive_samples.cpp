@@ -13,20 +13,24 @@ namespace CSA
 
 //--------------------------------------------------------------------------
 
-AdaptiveSamples::AdaptiveSamples(const RLCSA& rlcsa, const std::string& base_name) :
+AdaptiveSamples::AdaptiveSamples(const RLCSA& rlcsa, const std::string& base_name, usint _threads) :
   index(rlcsa),
   samples(0), size(0), items(0),
   candidate_samples(0), c_items(0),
-  regular_samples(0),
-  text_start(0),
+  regular_samples(0), sequence_starts(0),
   promote_probability(0.0),
-  pos(0), sum(0), window(0),
+  windows(0), threads(std::max(_threads, (usint)1)),
+#ifdef MULTITHREAD_SUPPORT
+  locks(0), c_locks(0),
+#endif
   ok(false)
 {
   Parameters parameters;
+  parameters.set(SAMPLE_WINDOW_SIZE);
   parameters.read(base_name + PARAMETERS_EXTENSION);
   this->use_candidates = parameters.get(CANDIDATE_SAMPLES);
   this->half_greedy = parameters.get(HALF_GREEDY_SAMPLES);
+  this->warm_start = false;
   this->window_size = parameters.get(SAMPLE_WINDOW_SIZE);
 
   if(parameters.get(SAMPLE_PROMOTE_RATE) > 0)
@@ -45,10 +49,21 @@ AdaptiveSamples::AdaptiveSamples(const RLCSA& rlcsa, const std::string& base_nam
   // Determine the number of adaptive, candidate, and regular samples.
   usint total_samples = 0;
   usint sample_rate = parameters.get(SAMPLE_RATE);
-  sample_file.read((char*)&(total_samples), sizeof(total_samples)); // Actually text size.
-  sample_file.read((char*)&(total_samples), sizeof(total_samples));
+  bool weighted = parameters.get(WEIGHTED_SAMPLES);
+  SASamples* initial = 0;
+  if(weighted)
+  {
+    sample_file.read((char*)&(total_samples), sizeof(total_samples)); // Actually text size.
+    sample_file.read((char*)&(total_samples), sizeof(total_samples));
+  }
+  else
+  {
+    initial = new SASamples(sample_file, sample_rate, false);
+    total_samples = initial->getNumberOfSamples();
+  }
   this->size = (this->half_greedy ? total_samples / 2 : total_samples);
   if(this->use_candidates) { this->size /= 2; }
+  this->size = std::max(this->size, (usint)1);
 
   // Initialize the samples.
   this->samples = new sample_type[this->size];
@@ -63,36 +78,72 @@ AdaptiveSamples::AdaptiveSamples(const RLCSA& rlcsa, const std::string& base_nam
   }
 
   // Insert the initial samples.
-  pair_type buffer;
   pair_type* regulars = 0;
   usint reg_samples = 0;
-  if(this->half_greedy) { regulars = new pair_type[total_samples / 2]; }
-  for(usint i = 0; i < total_samples; i++)
+  if(this->half_greedy) { regulars = new pair_type[total_samples / 2 + 1]; }
+  if(weighted)
   {
-    sample_file.read((char*)&buffer, sizeof(pair_type));
-    if(this->half_greedy && buffer.second % (2 * sample_rate) == 0)
+    pair_type buffer;
+    for(usint i = 0; i < total_samples; i++)
     {
-      regulars[reg_samples++] = buffer;
+      sample_file.read((char*)&buffer, sizeof(pair_type));
+      this->insertInitialSample(buffer, sample_rate, regulars, reg_samples);
     }
-    else
+  }
+  else
+  {
+    for(usint i = 0, j = 0; i < total_samples; i++)
     {
-      this->addSample(sample_type(buffer.first, buffer.second));
+      pair_type next = initial->getFirstSampleAfter(j);
+      this->insertInitialSample(pair_type(next.first, initial->getSample(next.second)), sample_rate, regulars, reg_samples);
+      j = next.first + 1;
     }
-    if(buffer.second == 0) { this->text_start = buffer.first; }
   }
   if(this->half_greedy)
   {
-    this->regular_samples = new SASamples(regulars, this->index.getSize(), 2 * sample_rate, 1);
+    // Padding makes every multiple of the sample rate in the text a sampled position.
+    this->regular_samples = new SASamples(regulars, this->index.getTextSize(), 2 * sample_rate, 1);
     delete[] regulars; regulars = 0;
+
+    // A sequence may start at an odd multiple of the sample rate.
+    if(initial != 0 && this->index.getNumberOfSequences() > 1)
+    {
+      this->sequence_starts = new usint[this->index.getNumberOfSequences()];
+      for(usint i = 0; i < this->index.getNumberOfSequences(); i++)
+      {
+        this->sequence_starts[i] = initial->inverseSA(this->index.getSequenceRange(i).first).second;
+      }
+    }
   }
+  delete initial; initial = 0;
+  this->warm_start = this->readTables(base_name);
 
-  // Initialize the window.
+  // Initialize the windows.
   if(this->promote_probability > 0.0)
   {
-    this->window = new key_type[this->window_size];
-    for(usint i = 0; i < this->window_size; i++) { this->window[i] = sample_rate / 2; }
-    this->sum = this->window_size * sample_rate / 2;
+    this->windows = new Window[this->threads];
+    for(usint t = 0; t < this->threads; t++)
+    {
+      this->windows[t].steps = new key_type[this->window_size];
+      for(usint i = 0; i < this->window_size; i++) { this->windows[t].steps[i] = sample_rate / 2; }
+      this->windows[t].pos = 0;
+      this->windows[t].sum = this->window_size * sample_rate / 2;
+      this->windows[t].seed = 0xDEADBEEF + t;
+    }
+  }
+
+#ifdef MULTITHREAD_SUPPORT
+  if(this->threads > 1)
+  {
+    this->locks = new omp_lock_t[LOCK_STRIPES];
+    for(usint i = 0; i < LOCK_STRIPES; i++) { omp_init_lock(this->locks + i); }
+    if(this->use_candidates)
+    {
+      this->c_locks = new omp_lock_t[LOCK_STRIPES];
+      for(usint i = 0; i < LOCK_STRIPES; i++) { omp_init_lock(this->c_locks + i); }
+    }
   }
+#endif
 
   sample_file.close();
   this->ok = true;
@@ -103,7 +154,24 @@ AdaptiveSamples::~AdaptiveSamples()
   delete[] samples; samples = 0;
   delete[] candidate_samples; candidate_samples = 0;
   delete   regular_samples; regular_samples = 0;
-  delete[] window; window = 0;
+  delete[] sequence_starts; sequence_starts = 0;
+  if(this->windows != 0)
+  {
+    for(usint t = 0; t < this->threads; t++) { delete[] this->windows[t].steps; }
+    delete[] this->windows; this->windows = 0;
+  }
+#ifdef MULTITHREAD_SUPPORT
+  if(this->locks != 0)
+  {
+    for(usint i = 0; i < LOCK_STRIPES; i++) { omp_destroy_lock(this->locks + i); }
+    delete[] this->locks; this->locks = 0;
+  }
+  if(this->c_locks != 0)
+  {
+    for(usint i = 0; i < LOCK_STRIPES; i++) { omp_destroy_lock(this->c_locks + i); }
+    delete[] this->c_locks; this->c_locks = 0;
+  }
+#endif
 }
 
 //--------------------------------------------------------------------------
@@ -142,7 +210,11 @@ AdaptiveSamples::reportSize() const
   usint temp = sizeof(*this) + this->size * sizeof(sample_type);
   if(this->use_candidates) { temp += this->size * sizeof(sample_type); }
   if(this->half_greedy) { temp += this->regular_samples->reportSize(); }
-  if(this->promote_probability > 0.0) { temp += this->window_size * sizeof(key_type); }
+  if(this->sequence_starts != 0) { temp += this->index.getNumberOfSequences() * sizeof(usint); }
+  if(this->promote_probability > 0.0)
+  {
+    temp += this->threads * (sizeof(Window) + this->window_size * sizeof(key_type));
+  }
   return temp;
 }
 
@@ -160,11 +232,107 @@ AdaptiveSamples::report() const
   {
     std::cout << " random(" << this->promote_probability << ", " << this->window_size << ")";
   }
+  if(this->threads > 1) { std::cout << " concurrent(" << this->threads << ")"; }
+  if(this->warm_start) { std::cout << " warm-start"; }
   std::cout << std::endl;
 
   std::cout << std::endl;
 }
 
+void
+AdaptiveSamples::writeTo(const std::string& base_name) const
+{
+  std::string output_name = base_name + ADAPTIVE_SAMPLES_EXTENSION;
+  std::ofstream output(output_name.c_str(), std::ios_base::binary);
+  if(!output)
+  {
+    std::cerr << "AdaptiveSamples: Error creating output file " << output_name << "!" << std::endl;
+    return;
+  }
+
+  usint flags = (this->use_candidates ? 1 : 0) | (this->half_greedy ? 2 : 0);
+  usint identity = this->index.getIdentity();
+  output.write((char*)&(this->size), sizeof(this->size));
+  output.write((char*)&flags, sizeof(flags));
+  output.write((char*)&identity, sizeof(identity));
+  output.write((char*)&(this->items), sizeof(this->items));
+  output.write((char*)&(this->c_items), sizeof(this->c_items));
+  output.write((char*)(this->samples), this->size * sizeof(sample_type));
+  if(this->use_candidates)
+  {
+    output.write((char*)(this->candidate_samples), this->size * sizeof(sample_type));
+  }
+
+  output.close();
+}
+
+bool
+AdaptiveSamples::readTables(const std::string& base_name)
+{
+  std::string input_name = base_name + ADAPTIVE_SAMPLES_EXTENSION;
+  std::ifstream input(input_name.c_str(), std::ios_base::binary);
+  if(!input) { return false; }
+
+  usint table_size = 0, flags = 0;
+  input.read((char*)&table_size, sizeof(table_size));
+  input.read((char*)&flags, sizeof(flags));
+  usint expected = (this->use_candidates ? 1 : 0) | (this->half_greedy ? 2 : 0);
+  if(table_size != this->size || flags != expected)
+  {
+    std::cerr << "AdaptiveSamples: Ignoring " << input_name << " written with different parameters!" << std::endl;
+    return false;
+  }
+
+  // The samples of a rebuilt index would return wrong positions.
+  usint identity = 0;
+  input.read((char*)&identity, sizeof(identity));
+  if(identity != this->index.getIdentity())
+  {
+    std::cerr << "AdaptiveSamples: Ignoring " << input_name << " written for a different index!" << std::endl;
+    return false;
+  }
+
+  // Read into temporary tables, so that a truncated file leaves the initial samples intact.
+  usint new_items = 0, new_c_items = 0;
+  sample_type* new_samples = new sample_type[this->size];
+  sample_type* new_candidates = (this->use_candidates ? new sample_type[this->size] : 0);
+  input.read((char*)&new_items, sizeof(new_items));
+  input.read((char*)&new_c_items, sizeof(new_c_items));
+  input.read((char*)new_samples, this->size * sizeof(sample_type));
+  if(this->use_candidates)
+  {
+    input.read((char*)new_candidates, this->size * sizeof(sample_type));
+  }
+  bool ok = input.good();
+  input.close();
+  if(!ok)
+  {
+    std::cerr << "AdaptiveSamples: Error reading " << input_name << ", starting cold!" << std::endl;
+    delete[] new_samples; delete[] new_candidates;
+    return false;
+  }
+
+  this->items = new_items; this->c_items = new_c_items;
+  delete[] this->samples; this->samples = new_samples;
+  if(this->use_candidates) { delete[] this->candidate_samples; this->candidate_samples = new_candidates; }
+  return true;
+}
+
+void
+AdaptiveSamples::addWeights(weight_type* weights, weight_type weight) const
+{
+  if(weights == 0) { return; }
+
+  for(usint i = 0; i < this->size; i++)
+  {
+    if(this->samples[i].first < this->index.getSize()) { weights[this->samples[i].second] += weight; }
+    if(this->use_candidates && this->candidate_samples[i].first < this->index.getSize())
+    {
+      weights[this->candidate_samples[i].second] += weight;
+    }
+  }
+}
+
 //--------------------------------------------------------------------------
 
 usint
@@ -194,21 +362,21 @@ AdaptiveSamples::locate(usint i, bool steps)
     }
 
     // Priority 3: Primary samples.
-    key_type j = this->hash(i);
-    if(this->samples[j].first == i)
+    sample_type found = this->getSample(this->hash(i));
+    if(found.first == i)
     {
-      sample.second = this->samples[j].second - offset;
+      sample.second = found.second - offset;
       break;
     }
 
     // Priority 4: Candidate samples.
     if(this->use_candidates)
     {
-      j = this->secondaryHash(i);
-      if(this->candidate_samples[j].first == i)
+      found = this->getCandidate(this->secondaryHash(i));
+      if(found.first == i)
       {
-        sample.second = this->candidate_samples[j].second - offset;
-        this->addSample(this->candidate_samples[j]);
+        sample.second = found.second - offset;
+        this->addSample(found);
         break;
       }
     }
@@ -216,13 +384,19 @@ AdaptiveSamples::locate(usint i, bool steps)
     i = this->index.psi(i); offset++;
   }
 
-  if(offset > 0) { this->trySample(sample, offset); }
-
-  // Update the average number of steps taken.
   if(this->promote_probability > 0.0)
   {
-    this->sum = this->sum + offset - this->window[this->pos];
-    this->window[this->pos] = offset; this->pos = (this->pos + 1) % this->window_size;
+    Window& window = this->getWindow();
+    if(offset > 0) { this->trySample(sample, offset, window); }
+
+    // Update the average number of steps taken.
+    window.sum = window.sum + offset - window.steps[window.pos];
+    window.steps[window.pos] = offset; window.pos = (window.pos + 1) % this->window_size;
+  }
+  else if(offset > 0)
+  {
+    if(this->use_candidates) { this->addCandidate(sample); }
+    else                     { this->addSample(sample); }
   }
 
   return (steps ? offset : sample.second);
@@ -245,10 +419,19 @@ AdaptiveSamples::locate(pair_type range, bool steps)
 void
 AdaptiveSamples::display(pair_type range, uchar* data)
 {
-  if(!(this->supportsDisplay()) || isEmpty(range) || range.second >= this->index.getSize() || data == 0) { return; }
+  if(!(this->supportsDisplay()) || isEmpty(range) || range.second >= this->index.getTextSize() || data == 0) { return; }
+
+  // As in RLCSA::display(), the range must be within a single sequence.
+  usint sequence = this->index.getSequenceForPosition(range.first);
+  pair_type seq_range = this->index.getSequenceRange(sequence);
+  if(range.first < seq_range.first || range.second > seq_range.second) { return; }
 
   pair_type res = this->regular_samples->inverseSA(range.first);
   usint i = res.first, pos = res.second;
+  if(this->sequence_starts != 0 && i < seq_range.first)
+  {
+    i = seq_range.first; pos = this->sequence_starts[sequence];
+  }
   for(; i < range.first; i++)
   {
     pos = this->index.psi(pos);
@@ -264,57 +447,151 @@ AdaptiveSamples::display(pair_type range, uchar* data)
 
 //--------------------------------------------------------------------------
 
+void
+AdaptiveSamples::insertInitialSample(pair_type sample, usint sample_rate, pair_type* regulars, usint& reg_samples)
+{
+  if(this->half_greedy && sample.second % (2 * sample_rate) == 0)
+  {
+    regulars[reg_samples++] = sample;
+  }
+  else
+  {
+    this->addSample(sample_type(sample.first, sample.second));
+  }
+}
+
 void
 AdaptiveSamples::addSample(sample_type sample)
 {
   key_type i = this->hash(sample.first);
-  if(this->samples[i].first >= this->index.getSize()) { this->items++; }
-  else if(this->use_candidates) { this->addCandidate(this->samples[i]); }
+
+#ifdef MULTITHREAD_SUPPORT
+  if(this->locks != 0) { omp_set_lock(this->locks + i % LOCK_STRIPES); }
+#endif
+  sample_type old = this->samples[i];
   this->samples[i] = sample;
+#ifdef MULTITHREAD_SUPPORT
+  if(this->locks != 0) { omp_unset_lock(this->locks + i % LOCK_STRIPES); }
+#endif
+
+  // Move the replaced sample to the candidates outside the lock.
+  if(old.first >= this->index.getSize())
+  {
+    #pragma omp atomic
+    this->items++;
+  }
+  else if(this->use_candidates) { this->addCandidate(old); }
 }
 
 void
 AdaptiveSamples::addCandidate(sample_type sample)
 {
   key_type i = this->secondaryHash(sample.first);
-  if(this->candidate_samples[i].first >= this->index.getSize()) { this->c_items++; }
+
+#ifdef MULTITHREAD_SUPPORT
+  if(this->c_locks != 0) { omp_set_lock(this->c_locks + i % LOCK_STRIPES); }
+#endif
+  bool was_empty = (this->candidate_samples[i].first >= this->index.getSize());
   this->candidate_samples[i] = sample;
+#ifdef MULTITHREAD_SUPPORT
+  if(this->c_locks != 0) { omp_unset_lock(this->c_locks + i % LOCK_STRIPES); }
+#endif
+
+  if(was_empty)
+  {
+    #pragma omp atomic
+    this->c_items++;
+  }
 }
 
 void
-AdaptiveSamples::trySample(sample_type sample, usint offset)
+AdaptiveSamples::trySample(sample_type sample, usint offset, Window& window)
 {
-  if(this->promote_probability > 0.0)
-  {
-    double temp = (this->promote_probability * this->window_size * offset) / this->sum;
-    if(rand() / (RAND_MAX + 1.0) >= temp) { return; }
-  }
+  double temp = (this->promote_probability * this->window_size * offset) / window.sum;
+  double random = (this->threads > 1 ? rand_r(&(window.seed)) : rand()) / (RAND_MAX + 1.0);
+  if(random >= temp) { return; }
 
   if(this->use_candidates) { this->addCandidate(sample); }
   else                     { this->addSample(sample); }
 }
 
+AdaptiveSamples::sample_type
+AdaptiveSamples::getSample(key_type slot)
+{
+#ifdef MULTITHREAD_SUPPORT
+  if(this->locks != 0)
+  {
+    omp_set_lock(this->locks + slot % LOCK_STRIPES);
+    sample_type result = this->samples[slot];
+    omp_unset_lock(this->locks + slot % LOCK_STRIPES);
+    return result;
+  }
+#endif
+  return this->samples[slot];
+}
+
+AdaptiveSamples::sample_type
+AdaptiveSamples::getCandidate(key_type slot)
+{
+#ifdef MULTITHREAD_SUPPORT
+  if(this->c_locks != 0)
+  {
+    omp_set_lock(this->c_locks + slot % LOCK_STRIPES);
+    sample_type result = this->candidate_samples[slot];
+    omp_unset_lock(this->c_locks + slot % LOCK_STRIPES);
+    return result;
+  }
+#endif
+  return this->candidate_samples[slot];
+}
+
+AdaptiveSamples::Window&
+AdaptiveSamples::getWindow()
+{
+#ifdef MULTITHREAD_SUPPORT
+  return this->windows[omp_get_thread_num() % this->threads];
+#else
+  return this->windows[0];
+#endif
+}
+
 AdaptiveSamples::key_type
 AdaptiveSamples::hash(key_type key)
 {
+#ifdef MASSIVE_DATA_RLCSA
+  key = ~key + (key << 21);
+  key = key ^ (key >> 24);
+  key = (key + (key << 3)) + (key << 8);
+  key = key ^ (key >> 14);
+  key = (key + (key << 2)) + (key << 4);
+  key = key ^ (key >> 28);
+  key = key + (key << 31);
+#else
   key = ~key + (key << 15);
   key = key ^ (key >> 12);
   key = key + (key << 2);
   key = key ^ (key >> 4);
   key = key * 2057;
   key = key ^ (key >> 16);
+#endif
   return key % this->size;
 }
 
 AdaptiveSamples::key_type
 AdaptiveSamples::secondaryHash(key_type key)
 {
+#ifdef MASSIVE_DATA_RLCSA
+  key = (key ^ (key >> 30)) * 0xBF58476D1CE4E5B9UL;
+  key = (key ^ (key >> 27)) * 0x94D049BB133111EBUL;
+  key = key ^ (key >> 31);
+#else
   key = (key + 0x7ed55d16) + (key << 12);
   key = (key ^ 0xc761c23c) ^ (key >> 19);
   key = (key + 0x165667b1) + (key << 5);
   key = (key + 0xd3a2646c) ^ (key << 9);
   key = (key + 0xfd7046c5) + (key << 3);
   key = (key ^ 0xb55a4f09) ^ (key >> 16);
+#endif
   return key % this->size;
 }
 
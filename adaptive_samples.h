@@ -4,6 +4,10 @@
 
 #include <fstream>
 
+#ifdef MULTITHREAD_SUPPORT
+#include <omp.h>
+#endif
+
 #include "rlcsa.h"
 #include "misc/parameters.h"
 
@@ -13,6 +17,8 @@ namespace CSA
 
 //--------------------------------------------------------------------------
 
+const std::string ADAPTIVE_SAMPLES_EXTENSION = ".rlcsa.adaptive_samples";
+
 const parameter_type CANDIDATE_SAMPLES   = parameter_type("CANDIDATE_SAMPLES", 0);
 const parameter_type HALF_GREEDY_SAMPLES = parameter_type("HALF_GREEDY_SAMPLES", 0);
 const parameter_type SAMPLE_PROMOTE_RATE = parameter_type("SAMPLE_PROMOTE_RATE", 0);
@@ -22,18 +28,33 @@ const parameter_type SAMPLE_WINDOW_SIZE  = parameter_type("SAMPLE_WINDOW_SIZE",
 
 /*
   This uses both POSITIONS and RANGES parts of external module interface.
-  FIXME Currently supports only one sequence.
-  FIXME The implementation currently assumes regular sampling with Sampler as input.
-  FIXME Assumes that key_type is 32 bits.
+  The initial samples can be either regular samples of the RLCSA or weighted samples
+  produced by a Sampler, as determined by the WEIGHTED_SAMPLES parameter. Weighted
+  samples are currently available only for single-sequence collections.
+
+  With multiple sequences, the end of sequence markers are used as implicit samples
+  as in RLCSA::directLocate(). Half-greedy display also stores the SA indexes of the
+  sequence starts, so that it never has to start from an earlier sequence.
+
+  key_type has the same width as usint, and the hash functions mix all of its bits.
+
+  The learned hash tables can be written with writeTo(). If the file exists when the
+  samples are constructed, and it was written for the same index (see
+  RLCSA::getIdentity()) with the same parameters, the tables are loaded from it instead
+  of the initial samples.
+
+  With threads > 1, locate() and display() can be called concurrently from that many
+  OpenMP threads. The hash table slots are then protected by striped locks, and each
+  thread (identified by omp_get_thread_num()) has its own promotion window.
 */
 
 class AdaptiveSamples
 {
   public:
-    typedef uint key_type;
+    typedef usint key_type;
     typedef std::pair<key_type, key_type> sample_type;
 
-    AdaptiveSamples(const RLCSA& rlcsa, const std::string& base_name);
+    AdaptiveSamples(const RLCSA& rlcsa, const std::string& base_name, usint threads = 1);
     ~AdaptiveSamples();
 
 //--------------------------------------------------------------------------
@@ -41,6 +62,7 @@ class AdaptiveSamples
     inline bool isOk() const { return this->ok; }
     inline bool supportsLocate() const { return true; }
     inline bool supportsDisplay() const { return this->half_greedy; }
+    inline bool isWarmStart() const { return this->warm_start; }
 
     usint getNumberOfSamples() const;
     double getLoad() const;
@@ -50,10 +72,18 @@ class AdaptiveSamples
     usint reportSize() const;
     void report() const;
 
+    // Writes the hash tables. The samples must not be in concurrent use.
+    void writeTo(const std::string& base_name) const;
+
+    // Adds 'weight' to the weights of all text positions in the hash tables.
+    // The weights array must cover the positions of the RLCSA.
+    void addWeights(weight_type* weights, weight_type weight) const;
+
 //--------------------------------------------------------------------------
 
     usint locate(usint i, bool steps);
     usint* locate(pair_type range, bool steps);
+    // Does nothing if the range is not within a single sequence.
     void display(pair_type range, uchar* data);
 
 //--------------------------------------------------------------------------
@@ -68,19 +98,44 @@ class AdaptiveSamples
     usint        c_items;
 
     SASamples*   regular_samples;
+    usint*       sequence_starts;  // SA indexes of sequence starts for half-greedy display.
 
-    key_type text_start;
-
-    bool      use_candidates, half_greedy;
+    bool      use_candidates, half_greedy, warm_start;
     double    promote_probability;
-    usint     window_size, pos, sum;
-    key_type* window;
+    usint     window_size;
+
+    // Sliding window of the steps taken in the latest queries.
+    struct Window
+    {
+      key_type* steps;
+      usint     pos, sum;
+      uint      seed;
+    };
+    Window*   windows;
+    usint     threads;
+
+#ifdef MULTITHREAD_SUPPORT
+    const static usint LOCK_STRIPES = 1024;
+    omp_lock_t* locks;
+    omp_lock_t* c_locks;
+#endif
 
     bool ok;
-    
+
+    // Returns true if the tables were loaded.
+    bool readTables(const std::string& base_name);
+
+    void insertInitialSample(pair_type sample, usint sample_rate, pair_type* regulars, usint& reg_samples);
+
     void addSample(sample_type sample);
     void addCandidate(sample_type sample);
-    void trySample(sample_type sample, usint offsets);
+    void trySample(sample_type sample, usint offsets, Window& window);
+
+    // Read a hash table slot without tearing the pair.
+    sample_type getSample(key_type slot);
+    sample_type getCandidate(key_type slot);
+
+    Window& getWindow();
 
     key_type hash(key_type key);
     key_type secondaryHash(key_type key);
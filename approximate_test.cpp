@@ -0,0 +1,203 @@
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "rlcsa.h"
+#include "misc/utils.h"
+
+
+using namespace CSA;
+
+
+/*
+  This program checks RLCSA::approximateCount() against a brute force search. Patterns
+  are sampled from the collection, and for each pattern, count() is called for every
+  string within the given number of errors. The ranges returned by approximateCount()
+  must be sorted and disjoint, and they must cover the same suffixes as the brute force
+  ranges. With edits, approximateCount() does not insert characters before the first
+  character of the pattern, so the brute force uses the same restriction.
+*/
+
+
+void addNeighbors(const std::string& str, const std::vector<uchar>& chars, bool edits, std::set<std::string>& result);
+void normalize(std::vector<pair_type>& ranges);
+usint editDistance(const std::string& text, const std::string& pattern);
+
+
+int
+main(int argc, char** argv)
+{
+  std::cout << "Approximate search test" << std::endl;
+  if(argc < 2)
+  {
+    std::cout << "Usage: approximate_test [-e] base_name [patterns [length [errors]]]" << std::endl;
+    std::cout << "  -e   Allow edit operations instead of just mismatches." << std::endl;
+    return 1;
+  }
+
+  int arg = 1;
+  bool edits = false;
+  if(argv[arg][0] == '-')
+  {
+    if(argv[arg][1] == 'e') { edits = true; }
+    arg++;
+  }
+  if(arg >= argc) { std::cerr << "Error: No base name!" << std::endl; return 1; }
+  std::string base_name = argv[arg]; arg++;
+  usint patterns = (arg < argc ? atoi(argv[arg]) : 1000); arg++;
+  usint len = (arg < argc ? atoi(argv[arg]) : 8); arg++;
+  usint errors = (arg < argc ? atoi(argv[arg]) : 1); arg++;
+  if(len <= errors)
+  {
+    std::cerr << "Error: Pattern length must be greater than the number of errors!" << std::endl;
+    return 1;
+  }
+
+  std::cout << "Base name: " << base_name << std::endl;
+  std::cout << "Patterns: " << patterns << std::endl;
+  std::cout << "Pattern length: " << len << std::endl;
+  std::cout << "Errors: " << errors << (edits ? " (edits)" : " (mismatches)") << std::endl;
+  std::cout << std::endl;
+
+  RLCSA rlcsa(base_name, false);
+  if(!rlcsa.isOk()) { return 2; }
+
+  std::vector<uchar> chars;
+  for(usint c = 0; c < CHARS; c++)
+  {
+    if(!isEmpty(rlcsa.getCharRange(c))) { chars.push_back(c); }
+  }
+
+  pair_type sa_range = rlcsa.getSARange();
+  uchar* buffer = new uchar[len];
+  usint tested = 0, failures = 0, overlaps = 0, total_ranges = 0;
+  std::srand(0xDEADBEEF);
+  double start = readTimer();
+  for(usint i = 0; i < patterns; i++)
+  {
+    usint index = sa_range.first + ((usint)std::rand() * RAND_MAX + std::rand()) % length(sa_range);
+    if(rlcsa.displayFromPosition(index, len, buffer) < len) { continue; }
+    std::string pattern((char*)buffer, len);
+    tested++;
+
+    std::vector<pair_type>* results = rlcsa.approximateCount(pattern, errors, edits);
+    total_ranges += results->size();
+    for(usint j = 1; j < results->size(); j++)
+    {
+      if((*results)[j].first <= (*results)[j - 1].second) { overlaps++; break; }
+    }
+
+    // Brute force.
+    std::set<std::string> neighbors; neighbors.insert(pattern);
+    for(usint k = 0; k < errors; k++)
+    {
+      std::set<std::string> next(neighbors);
+      for(std::set<std::string>::iterator iter = neighbors.begin(); iter != neighbors.end(); ++iter)
+      {
+        addNeighbors(*iter, chars, edits, next);
+      }
+      neighbors.swap(next);
+    }
+    std::vector<pair_type> expected;
+    for(std::set<std::string>::iterator iter = neighbors.begin(); iter != neighbors.end(); ++iter)
+    {
+      if(iter->empty()) { continue; }
+      if(edits && editDistance(*iter, pattern) > errors) { continue; }
+      pair_type range = rlcsa.count(*iter);
+      if(!isEmpty(range)) { expected.push_back(range); }
+    }
+
+    std::vector<pair_type> found(*results);
+    normalize(found); normalize(expected);
+    if(found != expected)
+    {
+      if(failures < 10)
+      {
+        std::cerr << "Error: Pattern " << pattern << ": " << found.size() << " ranges, expected "
+                  << expected.size() << "!" << std::endl;
+      }
+      failures++;
+    }
+    delete results;
+  }
+  double seconds = readTimer() - start;
+  delete[] buffer; buffer = 0;
+
+  std::cout << "Tested " << tested << " patterns (" << total_ranges << " ranges) in " << seconds << " seconds" << std::endl;
+  std::cout << "Wrong results: " << failures << std::endl;
+  std::cout << "Overlapping results: " << overlaps << std::endl;
+  std::cout << std::endl;
+
+  return (failures > 0 || overlaps > 0 ? 3 : 0);
+}
+
+
+void
+addNeighbors(const std::string& str, const std::vector<uchar>& chars, bool edits, std::set<std::string>& result)
+{
+  for(usint i = 0; i < str.length(); i++)
+  {
+    for(usint c = 0; c < chars.size(); c++)
+    {
+      std::string temp(str); temp[i] = chars[c];
+      result.insert(temp);
+    }
+    if(edits)
+    {
+      std::string temp(str); temp.erase(i, 1);
+      result.insert(temp);
+    }
+  }
+  if(edits)
+  {
+    for(usint i = 0; i <= str.length(); i++)
+    {
+      for(usint c = 0; c < chars.size(); c++)
+      {
+        std::string temp(str); temp.insert(i, 1, chars[c]);
+        result.insert(temp);
+      }
+    }
+  }
+}
+
+// Sorts the ranges and merges the overlapping and adjacent ones.
+void
+normalize(std::vector<pair_type>& ranges)
+{
+  sequentialSort(ranges.begin(), ranges.end());
+  usint tail = 0;
+  for(usint i = 0; i < ranges.size(); i++)
+  {
+    if(tail > 0 && ranges[i].first <= ranges[tail - 1].second + 1)
+    {
+      ranges[tail - 1].second = std::max(ranges[tail - 1].second, ranges[i].second);
+      continue;
+    }
+    ranges[tail] = ranges[i]; tail++;
+  }
+  ranges.resize(tail);
+}
+
+// Edit distance, where the text may not start with an inserted character.
+usint
+editDistance(const std::string& text, const std::string& pattern)
+{
+  usint n = text.length(), m = pattern.length();
+  std::vector<usint> prev(m + 1), curr(m + 1);
+  for(usint j = 0; j <= m; j++) { prev[j] = j; }
+  for(usint i = 1; i <= n; i++)
+  {
+    curr[0] = n + m;
+    for(usint j = 1; j <= m; j++)
+    {
+      curr[j] = std::min(prev[j - 1] + (text[i - 1] == pattern[j - 1] ? 0 : 1), curr[j - 1] + 1);
+      curr[j] = std::min(curr[j], prev[j] + 1);
+    }
+    prev.swap(curr);
+  }
+  return prev[m];
+}
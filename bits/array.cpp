@@ -2,6 +2,7 @@
 #include <cstdlib>
 
 #include "array.h"
+#include "wordallocator.h"
 
 
 namespace CSA
@@ -15,7 +16,7 @@ Array::Array(std::ifstream& file) :
   file.read((char*)&(this->number_of_blocks), sizeof(this->number_of_blocks));
   file.read((char*)&(this->block_size), sizeof(this->block_size));
 
-  this->array = new usint[this->block_size * this->number_of_blocks];
+  this->array = WordAllocator::allocate(this->block_size * this->number_of_blocks);
   file.read((char*)(this->array), this->block_size * this->number_of_blocks * sizeof(usint));
   this->buffer = new ReadBuffer(this->array, this->block_size);
 
@@ -32,7 +33,7 @@ Array::Array(FILE* file) :
   if(!std::fread(&(this->number_of_blocks), sizeof(this->number_of_blocks), 1, file)) { return; }
   if(!std::fread(&(this->block_size), sizeof(this->block_size), 1, file)) { return; }
 
-  this->array = new usint[this->block_size * this->number_of_blocks];
+  this->array = WordAllocator::allocate(this->block_size * this->number_of_blocks);
   if(!std::fread(this->array, this->block_size * sizeof(usint), this->number_of_blocks, file)) { return; }
   this->buffer = new ReadBuffer(this->array, this->block_size);
 
@@ -49,7 +50,7 @@ Array::Array(Encoder& encoder) :
   number_of_blocks(encoder.blocks),
   item_index(0)
 {
-  usint* array_buffer = new usint[this->block_size * this->number_of_blocks];
+  usint* array_buffer = WordAllocator::allocate(this->block_size * this->number_of_blocks);
   this->array = array_buffer;
   this->buffer = new ReadBuffer(this->array, this->block_size);
 
@@ -87,7 +88,7 @@ Array::Array(Encoder& encoder) :
 
 Array::~Array()
 {
-  if(this->delete_array) { delete[] this->array; }
+  if(this->delete_array) { WordAllocator::release(this->array); }
   delete this->buffer;
   delete this->samples;
   delete this->item_index;
@@ -2,6 +2,7 @@
 #include <cstring>
 
 #include "bitbuffer.h"
+#include "wordallocator.h"
 
 
 namespace CSA
@@ -15,7 +16,7 @@ ReadBuffer::ReadBuffer(std::ifstream& file, usint words) :
   items(0),
   free_buffer(true)
 {
-  usint* buffer = new usint[this->size];
+  usint* buffer = WordAllocator::allocate(this->size);
   memset(buffer, 0, this->size * sizeof(usint));
   file.read((char*)buffer, this->size * sizeof(usint));
   this->data = buffer;
@@ -28,7 +29,7 @@ ReadBuffer::ReadBuffer(FILE* file, usint words) :
   items(0),
   free_buffer(true)
 {
-  usint* buffer = new usint[this->size];
+  usint* buffer = WordAllocator::allocate(this->size);
   memset(buffer, 0, this->size * sizeof(usint));
   if(file != 0)
   {
@@ -44,7 +45,7 @@ ReadBuffer::ReadBuffer(std::ifstream& file, usint _items, usint item_size) :
   free_buffer(true)
 {
   this->size = bitsToWords(this->items * this->item_bits);
-  usint* buffer = new usint[this->size];
+  usint* buffer = WordAllocator::allocate(this->size);
   memset(buffer, 0, this->size * sizeof(usint));
   file.read((char*)buffer, this->size * sizeof(usint));
   this->data = buffer;
@@ -57,7 +58,7 @@ ReadBuffer::ReadBuffer(FILE* file, usint _items, usint item_size) :
   free_buffer(true)
 {
   this->size = bitsToWords(this->items * this->item_bits);
-  usint* buffer = new usint[this->size];
+  usint* buffer = WordAllocator::allocate(this->size);
   memset(buffer, 0, this->size * sizeof(usint));
   if(file != 0)
   {
@@ -101,7 +102,7 @@ ReadBuffer::~ReadBuffer()
 {
   if(this->free_buffer)
   {
-    delete[] this->data;
+    WordAllocator::release((usint*)(this->data));
   }
 }
 
@@ -131,7 +132,7 @@ ReadBuffer::moveBuffer(const usint* buffer)
 {
   if(this->free_buffer)
   {
-    delete[] this->data;
+    WordAllocator::release((usint*)(this->data));
   }
   this->free_buffer = false;
 
@@ -155,7 +156,7 @@ WriteBuffer::WriteBuffer(usint words) :
   items(0),
   free_buffer(true)
 {
-  this->data = new usint[words];
+  this->data = WordAllocator::allocate(words);
   memset(this->data, 0, this->size * sizeof(usint));
   this->reset();
 }
@@ -166,7 +167,7 @@ WriteBuffer::WriteBuffer(usint _items, usint item_size) :
   free_buffer(true)
 {
   this->size = bitsToWords(this->items * this->item_bits);
-  this->data = new usint[this->size];
+  this->data = WordAllocator::allocate(this->size);
   memset(this->data, 0, this->size * sizeof(usint));
   this->reset();
 }
@@ -195,7 +196,7 @@ WriteBuffer::~WriteBuffer()
 {
   if(this->free_buffer)
   {
-    delete[] this->data;
+    WordAllocator::release(this->data);
   }
 }
 
@@ -241,7 +242,7 @@ WriteBuffer::moveBuffer(usint* buffer)
 {
   if(this->free_buffer)
   {
-    delete[] this->data;
+    WordAllocator::release(this->data);
   }
   this->free_buffer = false;
 
@@ -1,7 +1,9 @@
+#include <algorithm>
 #include <cstring>
 #include <cstdlib>
 
 #include "bitvector.h"
+#include "wordallocator.h"
 
 
 namespace CSA
@@ -79,7 +81,7 @@ BitVector::BitVector() :
 
 BitVector::~BitVector()
 {
-  delete[] this->array;
+  WordAllocator::release((usint*)(this->array));
   delete this->samples;
   delete this->rank_index;
   delete this->select_index;
@@ -157,7 +159,7 @@ BitVector::readHeader(FILE* file)
 void
 BitVector::readArray(std::ifstream& file)
 {
-  usint* array_buffer = new usint[this->block_size * this->number_of_blocks];
+  usint* array_buffer = WordAllocator::allocate(this->block_size * this->number_of_blocks);
   file.read((char*)(array_buffer), this->block_size * this->number_of_blocks * sizeof(usint));
   this->array = array_buffer;
 }
@@ -166,7 +168,7 @@ void
 BitVector::readArray(FILE* file)
 {
   if(file == 0) { return; }
-  usint* array_buffer = new usint[this->block_size * this->number_of_blocks];
+  usint* array_buffer = WordAllocator::allocate(this->block_size * this->number_of_blocks);
   if(!std::fread(array_buffer, this->block_size * sizeof(usint), this->number_of_blocks, file)) { return; }
   this->array = array_buffer;
 }
@@ -182,7 +184,7 @@ BitVector::copyArray(VectorEncoder& encoder, bool use_directly)
     return;
   }
 
-  usint* array_buffer = new usint[this->block_size * this->number_of_blocks];
+  usint* array_buffer = WordAllocator::allocate(this->block_size * this->number_of_blocks);
   usint pos = 0, total_words = this->block_size * this->number_of_blocks;
 
   for(std::list<usint*>::iterator iter = encoder.array_blocks.begin(); iter != encoder.array_blocks.end(); iter++)
@@ -236,7 +238,7 @@ BitVector::indexForRank()
   usint value_samples = (this->number_of_blocks + BitVector::INDEX_RATE - 1) / BitVector::INDEX_RATE;
   this->rank_rate = (this->size + value_samples - 1) / value_samples;
   value_samples = (this->size + this->rank_rate - 1) / this->rank_rate + 1;
-  WriteBuffer index_buffer(value_samples, length(this->number_of_blocks - 1));
+  std::vector<usint> entries; entries.reserve(value_samples);
 
   // current is value, pointer is sample number.
   usint current = 0, pointer = 0;
@@ -247,14 +249,14 @@ BitVector::indexForRank()
     usint limit = this->samples->readItem();  // Next sampled value.
     while(current < limit)
     {
-      index_buffer.writeItem(pointer);
+      entries.push_back(pointer);
       current += this->rank_rate;
     }
     pointer++;
   }
-  index_buffer.writeItem(this->number_of_blocks - 1);
+  entries.push_back(this->number_of_blocks - 1);
 
-  this->rank_index = index_buffer.getReadBuffer();
+  this->rank_index = new BlockDirectory(entries);
 }
 
 void
@@ -265,7 +267,7 @@ BitVector::indexForSelect()
   usint index_samples = (this->number_of_blocks + BitVector::INDEX_RATE - 1) / BitVector::INDEX_RATE;
   this->select_rate = (this->items + index_samples - 1) / index_samples;
   index_samples = (this->items + this->select_rate - 1) / this->select_rate + 1;
-  WriteBuffer index_buffer(index_samples, length(this->number_of_blocks - 1));
+  std::vector<usint> entries; entries.reserve(index_samples);
 
   // current is index, pointer is sample number.
   usint current = 0, pointer = 0;
@@ -276,14 +278,14 @@ BitVector::indexForSelect()
     this->samples->skipItem();
     while(current < limit)
     {
-      index_buffer.writeItem(pointer);
+      entries.push_back(pointer);
       current += this->select_rate;
     }
     pointer++;
   }
-  index_buffer.writeItem(this->number_of_blocks - 1);
+  entries.push_back(this->number_of_blocks - 1);
 
-  this->select_index = index_buffer.getReadBuffer();
+  this->select_index = new BlockDirectory(entries);
 }
 
 //--------------------------------------------------------------------------
@@ -299,11 +301,24 @@ BitVector::Iterator::~Iterator()
 {
 }
 
+/*
+  The answer is in the range of blocks given by two consecutive index entries. Long
+  ranges are first narrowed down by binary search.
+*/
+
 usint
 BitVector::Iterator::sampleForIndex(usint index)
 {
-  usint low = this->parent.select_index->readItemConst(index / this->parent.select_rate);
-  usint high = this->parent.number_of_blocks - 1;
+  usint pos = index / this->parent.select_rate;
+  pair_type range = this->parent.select_index->range(pos);
+  usint low = range.first, high = range.second;
+
+  while(high - low > BitVector::LINEAR_SEARCH)
+  {
+    usint mid = low + (high - low + 1) / 2;
+    if(this->getSampledIndex(mid) <= index) { low = mid; }
+    else { high = mid - 1; }
+  }
 
   this->samples.goToItem(2 * low + 2);
   for(; low < high; low++)
@@ -318,8 +333,16 @@ BitVector::Iterator::sampleForIndex(usint index)
 usint
 BitVector::Iterator::sampleForValue(usint value)
 {
-  usint low = this->parent.rank_index->readItemConst(value / this->parent.rank_rate);
-  usint high = this->parent.number_of_blocks - 1;
+  usint pos = value / this->parent.rank_rate;
+  pair_type range = this->parent.rank_index->range(pos);
+  usint low = range.first, high = range.second;
+
+  while(high - low > BitVector::LINEAR_SEARCH)
+  {
+    usint mid = low + (high - low + 1) / 2;
+    if(this->getSampledValue(mid) <= value) { low = mid; }
+    else { high = mid - 1; }
+  }
 
   this->samples.goToItem(2 * low + 3);
   for(; low < high; low++)
@@ -333,6 +356,45 @@ BitVector::Iterator::sampleForValue(usint value)
 
 //--------------------------------------------------------------------------
 
+BlockDirectory::BlockDirectory(const std::vector<usint>& entries) :
+  size(entries.size())
+{
+  usint number_of_samples = (this->size + SAMPLE_RATE - 1) / SAMPLE_RATE;
+  usint max_offset = 0;
+  for(usint i = 0; i < this->size; i++)
+  {
+    max_offset = std::max(max_offset, entries[i] - entries[i - i % SAMPLE_RATE]);
+  }
+  usint max_value = (this->size > 0 ? entries[this->size - 1] : 0);
+
+  WriteBuffer sample_buffer(number_of_samples, std::max(length(max_value), (usint)1));
+  WriteBuffer offset_buffer(this->size, std::max(length(max_offset), (usint)1));
+  for(usint i = 0; i < this->size; i++)
+  {
+    if(i % SAMPLE_RATE == 0) { sample_buffer.writeItem(entries[i]); }
+    offset_buffer.writeItem(entries[i] - entries[i - i % SAMPLE_RATE]);
+  }
+
+  this->samples = sample_buffer.getReadBuffer();
+  this->offsets = offset_buffer.getReadBuffer();
+}
+
+BlockDirectory::~BlockDirectory()
+{
+  delete this->samples; this->samples = 0;
+  delete this->offsets; this->offsets = 0;
+}
+
+usint
+BlockDirectory::reportSize() const
+{
+  usint bytes = sizeof(*this);
+  bytes += this->samples->reportSize() + this->offsets->reportSize();
+  return bytes;
+}
+
+//--------------------------------------------------------------------------
+
 VectorEncoder::VectorEncoder(usint block_bytes, usint superblock_size, bool _use_small_blocks) :
   size(0), items(0), blocks(0),
   block_size(BYTES_TO_WORDS(block_bytes)),
@@ -341,7 +403,7 @@ VectorEncoder::VectorEncoder(usint block_bytes, usint superblock_size, bool _use
   blocks_in_superblock(1), current_blocks(0),
   samples(0), samples_in_superblock(0), current_samples(0)
 {
-  this->array = new usint[this->superblock_bytes / sizeof(usint)];
+  this->array = WordAllocator::allocate(this->superblock_bytes / sizeof(usint));
   memset(this->array, 0, this->superblock_bytes);
   if(use_small_blocks)
   {
@@ -359,12 +421,12 @@ VectorEncoder::VectorEncoder(usint block_bytes, usint superblock_size, bool _use
 
 VectorEncoder::~VectorEncoder()
 {
-  delete[] this->array;
+  WordAllocator::release(this->array);
 
   delete this->buffer;
   for(std::list<usint*>::iterator iter = this->array_blocks.begin(); iter != this->array_blocks.end(); iter++)
   {
-    delete[] *iter;
+    WordAllocator::release(*iter);
   }
 
   delete[] this->samples;
@@ -382,7 +444,7 @@ VectorEncoder::addNewBlock()
   if(this->current_blocks > this->blocks_in_superblock)
   {
     this->array_blocks.push_back(this->array);
-    this->array = new usint[this->superblock_bytes / sizeof(usint)];
+    this->array = WordAllocator::allocate(this->superblock_bytes / sizeof(usint));
     memset(this->array, 0, this->superblock_bytes);
     this->current_blocks = 1;
   }
@@ -4,6 +4,7 @@
 #include <cstdio>
 #include <fstream>
 #include <list>
+#include <vector>
 
 #include "../misc/definitions.h"
 #include "bitbuffer.h"
@@ -67,6 +68,51 @@ class VectorEncoder
 };
 
 
+/*
+  A two-level directory of nondecreasing values, such as block numbers or cumulative
+  ranks, used in the rank/select indexes. Every SAMPLE_RATE-th entry is stored as an
+  absolute value, while each entry is stored as an offset from the preceding absolute
+  value. The offsets are usually small, so a dense directory takes only a few bits per
+  entry.
+*/
+
+class BlockDirectory
+{
+  public:
+    const static usint SAMPLE_RATE = 64;
+
+    explicit BlockDirectory(const std::vector<usint>& entries);
+    ~BlockDirectory();
+
+    inline usint operator[] (usint i) const
+    {
+      return this->samples->readItemConst(i / SAMPLE_RATE) + this->offsets->readItemConst(i);
+    }
+
+    // Returns (entry i, entry i + 1), reading the absolute value only once when possible.
+    inline pair_type range(usint i) const
+    {
+      usint sample = this->samples->readItemConst(i / SAMPLE_RATE);
+      usint next = ((i + 1) % SAMPLE_RATE == 0 ? this->samples->readItemConst((i + 1) / SAMPLE_RATE) : sample);
+      return pair_type(sample + this->offsets->readItemConst(i), next + this->offsets->readItemConst(i + 1));
+    }
+
+    inline usint getSize() const { return this->size; }
+
+    usint reportSize() const;
+
+  private:
+    usint       size;
+    ReadBuffer* samples;
+    ReadBuffer* offsets;
+
+    // These are not allowed.
+    BlockDirectory();
+    BlockDirectory(const BlockDirectory&);
+    BlockDirectory& operator = (const BlockDirectory&);
+};
+
+
 /*
   This class provides the core functionality for a bit vector.
   A bit vector must have at least one 1-bit.
@@ -75,7 +121,18 @@ class VectorEncoder
 class BitVector
 {
   public:
+    // The rank/select indexes contain about (number of blocks) / INDEX_RATE entries.
+    // Compile with -DVECTOR_INDEX_RATE=1 for faster queries at the expense of memory.
+#ifdef VECTOR_INDEX_RATE
+    static const usint INDEX_RATE = VECTOR_INDEX_RATE;
+#else
     static const usint INDEX_RATE = 5;
+#endif
+
+    // sampleForIndex / sampleForValue take the range of candidate blocks from the index
+    // and binary search it until at most LINEAR_SEARCH blocks remain. The lookup is a
+    // bounded search, not a direct computation: O(log r) steps for a range of r blocks.
+    static const usint LINEAR_SEARCH = 8;
 
     explicit BitVector(std::ifstream& file);
     explicit BitVector(FILE* file);
@@ -209,11 +266,17 @@ class BitVector
     ReadBuffer*  samples;
     usint        integer_bits;
 
-    ReadBuffer*  rank_index;
-    usint        rank_rate;
+    /*
+      rank_index[i] is the block containing value i * rank_rate, and select_index[i] is
+      the block containing the 1-bit of rank i * select_rate + 1. The last entry of both
+      indexes is number_of_blocks - 1. SuccinctVector uses these members for its own
+      indexes.
+    */
+    BlockDirectory* rank_index;
+    usint           rank_rate;
 
-    ReadBuffer*  select_index;
-    usint        select_rate;
+    BlockDirectory* select_index;
+    usint           select_rate;
 
     /*
        These functions build a higher level index for faster rank/select queries.
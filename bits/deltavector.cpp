@@ -187,6 +187,25 @@ DeltaVector::Iterator::isSet(usint value)
   return (this->val == value);
 }
 
+usint
+DeltaVector::Iterator::countRuns()
+{
+  const DeltaVector& par = (const DeltaVector&)(this->parent);
+
+  if(par.items == 0) { return 0; }
+
+  usint runs = 1;
+  usint prev = this->select(0);
+  while(this->hasNext())
+  {
+    usint temp = this->selectNext();
+    if(temp != prev + 1) { runs++; }
+    prev = temp;
+  }
+
+  return runs;
+}
+
 //--------------------------------------------------------------------------
 
 DeltaEncoder::DeltaEncoder(usint block_bytes, usint superblock_size) :
@@ -74,7 +74,7 @@ class DeltaVector : public BitVector
 
         bool isSet(usint value);
 
-        usint countRuns();  // Not implemented.
+        usint countRuns();
 
       protected:
 
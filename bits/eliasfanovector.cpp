@@ -0,0 +1,393 @@
+#include <cstring>
+#include <iostream>
+
+#include "eliasfanovector.h"
+#include "wordallocator.h"
+
+
+namespace CSA
+{
+
+
+// Returns the offset of the 1-bit of rank k + 1 in the word, counting from the most
+// significant bit. Assumes that such a 1-bit exists.
+inline usint
+selectInWord(usint word, usint k)
+{
+  usint offset = 0;
+  for(usint width = WORD_BITS / 2; width > 0; width /= 2)
+  {
+    usint count = popcount(LOWER(word, WORD_BITS - width));
+    if(count <= k) { k -= count; offset += width; word = HIGHER(word, width); }
+  }
+  return offset;
+}
+
+//--------------------------------------------------------------------------
+
+EliasFanoVector::EliasFanoVector(std::ifstream& file) :
+  size(0), items(0), low_bits(0), high_bits(0),
+  high(0), low(0), one_samples(0), zero_samples(0)
+{
+  this->readFrom(file);
+  this->buildSamples();
+}
+
+EliasFanoVector::EliasFanoVector(FILE* file) :
+  size(0), items(0), low_bits(0), high_bits(0),
+  high(0), low(0), one_samples(0), zero_samples(0)
+{
+  if(file == 0) { return; }
+  this->readFrom(file);
+  this->buildSamples();
+}
+
+EliasFanoVector::EliasFanoVector(Encoder& encoder, usint universe_size) :
+  size(universe_size), items(encoder.items), low_bits(0), high_bits(0),
+  high(0), low(0), one_samples(0), zero_samples(0)
+{
+  if(this->items == 0)
+  {
+    std::cerr << "EliasFanoVector: Cannot create a bit vector with no 1-bits!" << std::endl;
+    return;
+  }
+
+  if(this->size > this->items) { this->low_bits = length(this->size / this->items) - 1; }
+  this->high_bits = this->items + ((this->size - 1) >> this->low_bits) + 1;
+
+  this->high = WordAllocator::allocate(this->getWords());
+  std::memset(this->high, 0, this->getWords() * sizeof(usint));
+  WriteBuffer* low_buffer = (this->low_bits > 0 ? new WriteBuffer(this->items, this->low_bits) : 0);
+  for(usint i = 0; i < this->items; i++)
+  {
+    usint value = encoder.values[i];
+    usint position = (value >> this->low_bits) + i;
+    this->high[position / WORD_BITS] |= (usint)1 << (WORD_BITS - position % WORD_BITS - 1);
+    if(low_buffer != 0) { low_buffer->writeItem(GET(value, this->low_bits)); }
+  }
+  if(low_buffer != 0)
+  {
+    this->low = low_buffer->getReadBuffer();
+    delete low_buffer; low_buffer = 0;
+  }
+
+  this->buildSamples();
+}
+
+EliasFanoVector::EliasFanoVector() :
+  size(0), items(0), low_bits(0), high_bits(0),
+  high(0), low(0), one_samples(0), zero_samples(0)
+{
+}
+
+EliasFanoVector::~EliasFanoVector()
+{
+  WordAllocator::release(this->high); this->high = 0;
+  delete this->low; this->low = 0;
+  delete this->one_samples; this->one_samples = 0;
+  delete this->zero_samples; this->zero_samples = 0;
+}
+
+//--------------------------------------------------------------------------
+
+void
+EliasFanoVector::writeTo(std::ofstream& file) const
+{
+  file.write((char*)&(this->size), sizeof(this->size));
+  file.write((char*)&(this->items), sizeof(this->items));
+  file.write((char*)&(this->low_bits), sizeof(this->low_bits));
+  file.write((char*)(this->high), this->getWords() * sizeof(usint));
+  if(this->low != 0) { this->low->writeBuffer(file); }
+}
+
+void
+EliasFanoVector::writeTo(FILE* file) const
+{
+  if(file == 0) { return; }
+  std::fwrite(&(this->size), sizeof(this->size), 1, file);
+  std::fwrite(&(this->items), sizeof(this->items), 1, file);
+  std::fwrite(&(this->low_bits), sizeof(this->low_bits), 1, file);
+  std::fwrite(this->high, sizeof(usint), this->getWords(), file);
+  if(this->low != 0) { this->low->writeBuffer(file); }
+}
+
+void
+EliasFanoVector::readFrom(std::ifstream& file)
+{
+  file.read((char*)&(this->size), sizeof(this->size));
+  file.read((char*)&(this->items), sizeof(this->items));
+  file.read((char*)&(this->low_bits), sizeof(this->low_bits));
+  this->high_bits = this->items + ((this->size - 1) >> this->low_bits) + 1;
+
+  this->high = WordAllocator::allocate(this->getWords());
+  file.read((char*)(this->high), this->getWords() * sizeof(usint));
+  if(this->low_bits > 0) { this->low = new ReadBuffer(file, this->items, this->low_bits); }
+}
+
+void
+EliasFanoVector::readFrom(FILE* file)
+{
+  if(!std::fread(&(this->size), sizeof(this->size), 1, file)) { return; }
+  if(!std::fread(&(this->items), sizeof(this->items), 1, file)) { return; }
+  if(!std::fread(&(this->low_bits), sizeof(this->low_bits), 1, file)) { return; }
+  this->high_bits = this->items + ((this->size - 1) >> this->low_bits) + 1;
+
+  this->high = WordAllocator::allocate(this->getWords());
+  if(!std::fread(this->high, sizeof(usint), this->getWords(), file)) { return; }
+  if(this->low_bits > 0) { this->low = new ReadBuffer(file, this->items, this->low_bits); }
+}
+
+usint
+EliasFanoVector::reportSize() const
+{
+  usint bytes = sizeof(*this) + this->getWords() * sizeof(usint);
+  if(this->low != 0) { bytes += this->low->reportSize(); }
+  if(this->one_samples != 0) { bytes += this->one_samples->reportSize(); }
+  if(this->zero_samples != 0) { bytes += this->zero_samples->reportSize(); }
+  return bytes;
+}
+
+//--------------------------------------------------------------------------
+
+void
+EliasFanoVector::buildSamples()
+{
+  usint zeros = this->high_bits - this->items;
+  WriteBuffer one_buffer((this->items + SAMPLE_RATE - 1) / SAMPLE_RATE, length(this->high_bits - 1));
+  WriteBuffer zero_buffer((zeros + SAMPLE_RATE - 1) / SAMPLE_RATE, length(this->high_bits - 1));
+
+  usint ones_seen = 0, zeros_seen = 0;
+  for(usint i = 0; i < this->high_bits; i++)
+  {
+    if(this->isHighSet(i))
+    {
+      if(ones_seen % SAMPLE_RATE == 0) { one_buffer.writeItem(i); }
+      ones_seen++;
+    }
+    else
+    {
+      if(zeros_seen % SAMPLE_RATE == 0) { zero_buffer.writeItem(i); }
+      zeros_seen++;
+    }
+  }
+
+  this->one_samples = one_buffer.getReadBuffer();
+  this->zero_samples = zero_buffer.getReadBuffer();
+}
+
+usint
+EliasFanoVector::selectOne(usint index) const
+{
+  usint position = this->one_samples->readItemConst(index / SAMPLE_RATE);
+  index %= SAMPLE_RATE;
+
+  usint word = position / WORD_BITS;
+  usint data = this->high[word] & (WORD_MAX >> (position % WORD_BITS));
+  for(usint count = popcount(data); count <= index; count = popcount(data))
+  {
+    index -= count; word++; data = this->high[word];
+  }
+
+  return word * WORD_BITS + selectInWord(data, index);
+}
+
+usint
+EliasFanoVector::selectZero(usint index) const
+{
+  usint position = this->zero_samples->readItemConst(index / SAMPLE_RATE);
+  index %= SAMPLE_RATE;
+
+  usint word = position / WORD_BITS;
+  usint data = ~(this->high[word]) & (WORD_MAX >> (position % WORD_BITS));
+  for(usint count = popcount(data); count <= index; count = popcount(data))
+  {
+    index -= count; word++; data = ~(this->high[word]);
+  }
+
+  return word * WORD_BITS + selectInWord(data, index);
+}
+
+usint
+EliasFanoVector::nextOne(usint position) const
+{
+  usint word = position / WORD_BITS;
+  usint data = this->high[word] & (WORD_MAX >> (position % WORD_BITS));
+  while(data == 0) { word++; data = this->high[word]; }
+
+  return word * WORD_BITS + selectInWord(data, 0);
+}
+
+//--------------------------------------------------------------------------
+
+EliasFanoVector::Iterator::Iterator(const EliasFanoVector& par) :
+  parent(par),
+  cur(0), pos(0), val(0)
+{
+}
+
+EliasFanoVector::Iterator::~Iterator()
+{
+}
+
+void
+EliasFanoVector::Iterator::seekValue(usint value)
+{
+  usint bucket = value >> this->parent.low_bits;
+  usint low_value = (this->parent.low_bits > 0 ? GET(value, this->parent.low_bits) : 0);
+
+  // The bucket starts after the 0-bit ending the previous bucket.
+  this->pos = (bucket == 0 ? 0 : this->parent.selectZero(bucket - 1) + 1);
+  this->cur = this->pos - bucket;
+  while(this->cur < this->parent.items && this->parent.isHighSet(this->pos) &&
+        this->parent.getLow(this->cur) < low_value)
+  {
+    this->cur++; this->pos++;
+  }
+
+  if(this->cur >= this->parent.items) { this->setEnd(); return; }
+  this->pos = this->parent.nextOne(this->pos);
+  this->setValue();
+}
+
+usint
+EliasFanoVector::Iterator::rank(usint value, bool at_least)
+{
+  if(value >= this->parent.size) { return this->parent.items; }
+
+  this->seekValue(value);
+  if(at_least || this->val == value) { return this->cur + 1; }
+  return this->cur;
+}
+
+usint
+EliasFanoVector::Iterator::select(usint index)
+{
+  if(index >= this->parent.items) { this->setEnd(); return this->parent.size; }
+
+  this->cur = index;
+  this->pos = this->parent.selectOne(index);
+  this->setValue();
+  return this->val;
+}
+
+usint
+EliasFanoVector::Iterator::selectNext()
+{
+  if(!(this->hasNext())) { this->setEnd(); return this->val; }
+
+  this->cur++;
+  this->pos = this->parent.nextOne(this->pos + 1);
+  this->setValue();
+  return this->val;
+}
+
+pair_type
+EliasFanoVector::Iterator::valueBefore(usint value)
+{
+  if(value >= this->parent.size) { return pair_type(this->parent.size, this->parent.items); }
+
+  usint temp = this->rank(value);
+  if(temp == 0) { return pair_type(this->parent.size, this->parent.items); }
+  return pair_type(this->select(temp - 1), temp - 1);
+}
+
+pair_type
+EliasFanoVector::Iterator::valueAfter(usint value)
+{
+  if(value >= this->parent.size) { return pair_type(this->parent.size, this->parent.items); }
+
+  this->seekValue(value);
+  return pair_type(this->val, this->cur);
+}
+
+pair_type
+EliasFanoVector::Iterator::nextValue()
+{
+  this->selectNext();
+  return pair_type(this->val, this->cur);
+}
+
+pair_type
+EliasFanoVector::Iterator::selectRun(usint index, usint max_length)
+{
+  return pair_type(this->select(index), 0);
+}
+
+pair_type
+EliasFanoVector::Iterator::selectNextRun(usint max_length)
+{
+  return pair_type(this->selectNext(), 0);
+}
+
+bool
+EliasFanoVector::Iterator::isSet(usint value)
+{
+  if(value >= this->parent.size) { return false; }
+
+  this->seekValue(value);
+  return (this->val == value);
+}
+
+usint
+EliasFanoVector::Iterator::countRuns()
+{
+  if(this->parent.items == 0) { return 0; }
+
+  usint runs = 1;
+  usint prev = this->select(0);
+  while(this->hasNext())
+  {
+    usint temp = this->selectNext();
+    if(temp != prev + 1) { runs++; }
+    prev = temp;
+  }
+
+  return runs;
+}
+
+//--------------------------------------------------------------------------
+
+EliasFanoEncoder::EliasFanoEncoder(usint block_bytes, usint superblock_size) :
+  size(0), items(0)
+{
+}
+
+EliasFanoEncoder::~EliasFanoEncoder()
+{
+}
+
+void
+EliasFanoEncoder::setBit(usint value)
+{
+  if(this->items > 0 && value < this->size) { return; }
+
+  this->values.push_back(value);
+  this->size = value + 1;
+  this->items++;
+}
+
+void
+EliasFanoEncoder::setRun(usint start, usint len)
+{
+  for(usint i = start; i < start + len; i++) { this->setBit(i); }
+}
+
+void
+EliasFanoEncoder::addBit(usint value)
+{
+  this->setBit(value);
+}
+
+void
+EliasFanoEncoder::addRun(usint start, usint len)
+{
+  this->setRun(start, len);
+}
+
+void
+EliasFanoEncoder::flush()
+{
+}
+
+
+} // namespace CSA
@@ -0,0 +1,182 @@
+#ifndef ELIASFANOVECTOR_H
+#define ELIASFANOVECTOR_H
+
+#include <cstdio>
+#include <fstream>
+#include <vector>
+
+#include "bitvector.h"
+
+
+namespace CSA
+{
+
+
+/*
+  This class is used to construct an EliasFanoVector.
+  The encoding is done when the vector is built, so the encoder just stores the 1-bits.
+*/
+
+class EliasFanoEncoder
+{
+  public:
+    // The parameters are only for compatibility with the other encoders.
+    EliasFanoEncoder(usint block_bytes, usint superblock_size = VectorEncoder::SUPERBLOCK_SIZE);
+    ~EliasFanoEncoder();
+
+    void setBit(usint value);  // Values must be in increasing order.
+    void setRun(usint start, usint len);
+
+    void addBit(usint value);
+    void addRun(usint start, usint len);
+    void flush();
+
+    usint size, items;
+    std::vector<usint> values;
+
+  protected:
+
+    // These are not allowed.
+    EliasFanoEncoder();
+    EliasFanoEncoder(const EliasFanoEncoder&);
+    EliasFanoEncoder& operator = (const EliasFanoEncoder&);
+};
+
+
+/*
+  This is an Elias-Fano encoded bit vector for sparse and evenly distributed 1-bits,
+  such as regularly sampled SA positions or sequence end points. The lowest
+  low_bits bits of each 1-bit are stored in a fixed-width array, while the high
+  bits are stored in unary in a bit array of items + (size >> low_bits) + 1 bits.
+  The upper bits of the 1-bit of rank i + 1 are the number of 0-bits before the
+  i-th 1-bit in the bit array.
+
+  Every SAMPLE_RATE-th 1-bit and 0-bit of the bit array are sampled, so select
+  scans only a few words, while rank and successor queries select the 0-bit
+  ending the previous bucket and scan the current bucket.
+*/
+
+class EliasFanoVector
+{
+  public:
+    typedef EliasFanoEncoder Encoder;
+
+    const static usint SAMPLE_RATE = 128;
+
+    explicit EliasFanoVector(std::ifstream& file);
+    explicit EliasFanoVector(FILE* file);
+    EliasFanoVector(Encoder& encoder, usint universe_size);
+    ~EliasFanoVector();
+
+//--------------------------------------------------------------------------
+
+    void writeTo(std::ofstream& file) const;
+    void writeTo(FILE* file) const;
+
+    inline usint getSize() const { return this->size; }
+    inline usint getNumberOfItems() const { return this->items; }
+
+    usint reportSize() const;
+
+    // There is nothing to remove.
+    void strip() {}
+
+//--------------------------------------------------------------------------
+
+    class Iterator
+    {
+      public:
+        explicit Iterator(const EliasFanoVector& par);
+        ~Iterator();
+
+        usint rank(usint value, bool at_least = false);
+
+        usint select(usint index);
+        usint selectNext();
+        inline bool hasNext() const { return (this->cur + 1 < this->parent.items); }
+
+        pair_type valueBefore(usint value);
+        pair_type valueAfter(usint value);
+        pair_type nextValue();
+
+        pair_type selectRun(usint index, usint max_length);
+        pair_type selectNextRun(usint max_length);
+
+        bool isSet(usint value);
+
+        usint countRuns();
+
+      protected:
+        const EliasFanoVector& parent;
+
+        usint cur, pos, val;  // Current 1-bit, its position in the bit array, and its value.
+
+        // Moves to the first 1-bit at or after value < size. Sets cur to parent.items if
+        // there is no such 1-bit.
+        void seekValue(usint value);
+
+        inline void setValue()
+        {
+          this->val = ((this->pos - this->cur) << this->parent.low_bits) | this->parent.getLow(this->cur);
+        }
+
+        inline void setEnd()
+        {
+          this->cur = this->parent.items;
+          this->val = this->parent.size;
+        }
+
+        // These are not allowed.
+        Iterator();
+        Iterator(const Iterator&);
+        Iterator& operator = (const Iterator&);
+    };
+
+//--------------------------------------------------------------------------
+
+  protected:
+    usint size, items;
+    usint low_bits, high_bits;  // high_bits is the length of the bit array.
+
+    usint*      high;
+    ReadBuffer* low;
+
+    ReadBuffer* one_samples;   // Position of the 1-bit of rank i * SAMPLE_RATE + 1.
+    ReadBuffer* zero_samples;  // Position of the 0-bit of rank i * SAMPLE_RATE + 1.
+
+    inline usint getLow(usint index) const
+    {
+      return (this->low == 0 ? 0 : this->low->readItemConst(index));
+    }
+
+    inline bool isHighSet(usint position) const
+    {
+      return this->high[position / WORD_BITS] & ((usint)1 << (WORD_BITS - position % WORD_BITS - 1));
+    }
+
+    // Positions of the 1-bit / 0-bit of rank index + 1 in the bit array.
+    usint selectOne(usint index) const;
+    usint selectZero(usint index) const;
+
+    // Position of the first 1-bit at or after position in the bit array. Assumes that
+    // such a 1-bit exists.
+    usint nextOne(usint position) const;
+
+    void buildSamples();
+
+    void readFrom(std::ifstream& file);
+    void readFrom(FILE* file);
+
+    inline usint getWords() const { return BITS_TO_WORDS(this->high_bits); }
+
+    // These are not allowed.
+    EliasFanoVector();
+    EliasFanoVector(const EliasFanoVector&);
+    EliasFanoVector& operator = (const EliasFanoVector&);
+};
+
+
+} // namespace CSA
+
+
+#endif // ELIASFANOVECTOR_H
@@ -107,18 +107,18 @@ SuccinctVector::indexForRank()
 {
   delete this->rank_index; this->rank_index = 0;
 
-  WriteBuffer buffer(this->number_of_blocks + 1, this->integer_bits);
+  std::vector<usint> entries; entries.reserve(this->number_of_blocks + 1);
   const usint* data = this->array;
 
-  buffer.writeItem(0);
+  entries.push_back(0);
   usint bitcount = 0;
   for(usint block = 0; block < this->number_of_blocks; block++)
   {
     for(usint word = 0; word < this->block_size; word++, ++data) { bitcount += popcount(*data); }
-    buffer.writeItem(bitcount);
+    entries.push_back(bitcount);
   }
 
-  this->rank_index = buffer.getReadBuffer();
+  this->rank_index = new BlockDirectory(entries);
 }
 
 void
@@ -128,22 +128,22 @@ SuccinctVector::indexForSelect()
 
   this->select_rate = (this->items + this->number_of_blocks - 1) / this->number_of_blocks;
   usint index_samples = (this->items + this->select_rate - 1) / this->select_rate + 1;
-  WriteBuffer buffer(index_samples, this->integer_bits);
+  std::vector<usint> entries; entries.reserve(index_samples);
 
   // pointer is the largest block number such that rank_index[pointer] <= current.
   usint pointer = 0;
-  usint next_rank = this->rank_index->readItem(1);
+  usint next_rank = (*(this->rank_index))[1];
   for(usint current = 0; current < this->items; current += this->select_rate)
   {
     while(next_rank <= current)
     {
-      pointer++; next_rank = this->rank_index->readItem();
+      pointer++; next_rank = (*(this->rank_index))[pointer + 1];
     }
-    buffer.writeItem(pointer);
+    entries.push_back(pointer);
   }
-  buffer.writeItem(this->number_of_blocks - 1);
+  entries.push_back(this->number_of_blocks - 1);
 
-  this->select_index = buffer.getReadBuffer();
+  this->select_index = new BlockDirectory(entries);
 }
 
 //--------------------------------------------------------------------------
@@ -165,8 +165,10 @@ SuccinctVector::Iterator::rank(usint value, bool at_least)
 
   if(value >= par.size) { return par.items; }
 
+  // With at_least, an unset bit at value counts as the next 1-bit.
+  usint result = (at_least && !(this->isSet(value)) ? 1 : 0);
   usint block = value / (par.block_size * WORD_BITS);
-  usint result = par.rank_index->readItemConst(block);
+  result += (*(par.rank_index))[block];
   const usint* data = par.array + block * par.block_size;
 
   // Value is now the number of bits to be read within the block.
@@ -191,34 +193,32 @@ usint
 SuccinctVector::Iterator::select(usint index)
 {
   const SuccinctVector& par = (const SuccinctVector&)(this->parent);
-  ReadBuffer rank_index(*(par.rank_index));
+  const BlockDirectory& rank_index = *(par.rank_index);
 
   if(index >= par.items) { return par.size; }
 
   // The range of blocks that contains the 1-bit of rank (index + 1).
-  usint low = par.select_index->readItemConst(index / par.select_rate);
-  usint high = par.select_index->readItemConst(index / par.select_rate + 1);
+  pair_type range = par.select_index->range(index / par.select_rate);
+  usint low = range.first, high = range.second;
 
   // Use binary search if the range is too long.
   while(high - low >= SuccinctVector::SHORT_RANGE)
   {
     usint mid = low + (high - low) / 2;
-    usint val = rank_index.readItem(mid);
+    usint val = rank_index[mid];
     if(val > index) { high = mid - 1; }
     else            { low = mid; }
   }
 
   // Find the correct block by linear search.
-  for(usint limit = rank_index.readItem(low + 1);
-      limit <= index;
-      limit = rank_index.readItem(), low++);
+  while(rank_index[low + 1] <= index) { low++; }
 
   // Finally scan the block to find the 1-bit of rank (index + 1).
   // result is the number of bits scanned.
   // cur is the rank of the last 1-bit in the scanned range.
   const usint* data = par.array + low * par.block_size;
   usint result = low * par.block_size * WORD_BITS;
-  this->cur = rank_index.readItem(low);
+  this->cur = rank_index[low];
   for(usint count = popcount(*data); this->cur + count <= index; count = popcount(*data))
   {
     ++data; result += WORD_BITS; this->cur += count;
@@ -290,7 +290,11 @@ SuccinctVector::Iterator::isSet(usint value)
 usint
 SuccinctVector::Iterator::countRuns()
 {
-  usint runs = 0;
+  const SuccinctVector& par = (const SuccinctVector&)(this->parent);
+
+  if(par.items == 0) { return 0; }
+
+  usint runs = 1;
   usint prev = this->select(0);
   while(this->hasNext())
   {
@@ -89,7 +89,7 @@ class SuccinctVector : public BitVector
 
         bool isSet(usint value);
 
-        usint countRuns();  // Not implemented.
+        usint countRuns();
 
       protected:
         const SuccinctVector& parent;
@@ -0,0 +1,124 @@
+#include <cstdlib>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "wordallocator.h"
+
+
+namespace CSA
+{
+
+
+/*
+  The word before the array contains the size of the mapping in bytes, or 0 if the
+  array was allocated with new[]. Mapped arrays start HEADER_WORDS words after the
+  beginning of the mapping to keep them aligned to cache lines.
+*/
+
+const usint HEADER_WORDS = 64 / sizeof(usint);
+
+// From <numaif.h>. We call mbind() directly to avoid depending on libnuma.
+const int MBIND_INTERLEAVE = 3;
+
+usint WordAllocator::policy = WordAllocator::DEFAULT_POLICY;
+usint WordAllocator::mapped_bytes = 0;
+
+inline usint
+roundUp(usint value, usint multiple)
+{
+  return multiple * ((value + multiple - 1) / multiple);
+}
+
+//--------------------------------------------------------------------------
+
+usint*
+WordAllocator::allocate(usint words)
+{
+  if((policy & POLICY_MASK) != HEAP && words * sizeof(usint) >= MAPPED_BYTES)
+  {
+    usint* data = allocateMapped(words * sizeof(usint));
+    if(data != 0) { return data; }
+  }
+
+  usint* buffer = new usint[words + 1];
+  buffer[0] = 0;
+  return buffer + 1;
+}
+
+void
+WordAllocator::release(usint* data)
+{
+  if(data == 0) { return; }
+
+  usint bytes = data[-1];
+  if(bytes == 0) { delete[] (data - 1); return; }
+
+  #ifdef __linux__
+  munmap(data - HEADER_WORDS, bytes);
+  __sync_fetch_and_sub(&mapped_bytes, bytes);
+  #endif
+}
+
+void
+WordAllocator::setPolicy(usint _policy)
+{
+  policy = _policy & (POLICY_MASK | INTERLEAVE);
+}
+
+//--------------------------------------------------------------------------
+
+usint*
+WordAllocator::allocateMapped(usint bytes)
+{
+  #ifdef __linux__
+  usint total = bytes + HEADER_WORDS * sizeof(usint);
+  char* base = 0;
+
+  #ifdef MAP_HUGETLB
+  if((policy & POLICY_MASK) == HUGETLB)
+  {
+    usint huge_total = roundUp(total, HUGE_PAGE_SIZE);
+    void* ptr = mmap(0, huge_total, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if(ptr != MAP_FAILED) { base = (char*)ptr; total = huge_total; }
+  }
+  #endif
+
+  if(base == 0)
+  {
+    // Map an extra huge page and unmap the ends to align the array to a huge page boundary.
+    total = roundUp(total, sysconf(_SC_PAGESIZE));
+    void* ptr = mmap(0, total + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(ptr == MAP_FAILED) { return 0; }
+
+    char* start = (char*)ptr;
+    base = start + (HUGE_PAGE_SIZE - (size_t)start % HUGE_PAGE_SIZE) % HUGE_PAGE_SIZE;
+    if(base > start) { munmap(start, base - start); }
+    munmap(base + total, start + HUGE_PAGE_SIZE - base);
+
+    #ifdef MADV_HUGEPAGE
+    madvise(base, total, MADV_HUGEPAGE);
+    #endif
+  }
+
+  // The pages have not been touched yet, so the policy applies to all of them.
+  if(policy & INTERLEAVE)
+  {
+    unsigned long nodes = ~0UL;
+    syscall(SYS_mbind, base, total, MBIND_INTERLEAVE, &nodes, sizeof(nodes) * CHAR_BIT, 0);
+  }
+
+  usint* data = (usint*)base + HEADER_WORDS;
+  data[-1] = total;
+  __sync_fetch_and_add(&mapped_bytes, total);
+  return data;
+  #else
+  return 0;
+  #endif
+}
+
+
+} // namespace CSA
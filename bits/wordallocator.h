@@ -0,0 +1,79 @@
+#ifndef WORDALLOCATOR_H
+#define WORDALLOCATOR_H
+
+#include "../misc/definitions.h"
+
+
+namespace CSA
+{
+
+
+/*
+  This class allocates the word arrays of bit vectors and buffers. By default, the
+  arrays are allocated with new[]. With other policies, arrays of at least MAPPED_BYTES
+  bytes are mapped with mmap() to reduce TLB misses on random access:
+
+    HEAP        use new[] for all arrays (default)
+    HUGE_PAGES  transparent huge pages with madvise(MADV_HUGEPAGE) (default with
+                -DHUGE_PAGE_ALLOCATION)
+    HUGETLB     explicit huge pages from the hugetlbfs pool (MAP_HUGETLB); falls back
+                to HUGE_PAGES if the pool is exhausted
+
+  Flag INTERLEAVE (default with -DNUMA_INTERLEAVE) can be combined with a mapping
+  policy to interleave the pages over the NUMA nodes with mbind(). Then the memory
+  bandwidth of all nodes is available to the threads of every node.
+
+  The policy can be changed at any time, but it only affects arrays allocated after
+  the change. Arrays from allocate() must be released with release().
+*/
+
+class WordAllocator
+{
+  public:
+    const static usint HEAP        = 0;
+    const static usint HUGE_PAGES  = 1;
+    const static usint HUGETLB     = 2;
+    const static usint POLICY_MASK = 3;
+
+    const static usint INTERLEAVE  = 4;
+
+    #ifdef HUGE_PAGE_ALLOCATION
+    #ifdef NUMA_INTERLEAVE
+    const static usint DEFAULT_POLICY = HUGE_PAGES | INTERLEAVE;
+    #else
+    const static usint DEFAULT_POLICY = HUGE_PAGES;
+    #endif
+    #else
+    const static usint DEFAULT_POLICY = HEAP;
+    #endif
+
+    const static usint HUGE_PAGE_SIZE = 2 * MEGABYTE;
+    const static usint MAPPED_BYTES   = HUGE_PAGE_SIZE;
+
+    // The array is not initialized.
+    static usint* allocate(usint words);
+    static void release(usint* data);
+
+    static void setPolicy(usint _policy);
+    inline static usint getPolicy() { return policy; }
+
+    // Returns the number of bytes currently allocated with mmap().
+    inline static usint mappedBytes() { return mapped_bytes; }
+
+  private:
+    static usint policy;
+    static usint mapped_bytes;
+
+    static usint* allocateMapped(usint bytes);
+
+    // These are not allowed.
+    WordAllocator();
+    WordAllocator(const WordAllocator&);
+    WordAllocator& operator = (const WordAllocator&);
+};
+
+
+} // namespace CSA
+
+
+#endif // WORDALLOCATOR_H
@@ -0,0 +1,64 @@
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+
+#include "rlcsa.h"
+#include "cst.h"
+#include "misc/utils.h"
+
+
+using namespace CSA;
+
+
+/*
+  This program builds the range minimum structure of the compressed suffix tree for an
+  index that supports locate. The PLCP must have been built with build_plcp. The structure
+  is written to base_name.rlcsa.cst.
+*/
+
+
+int
+main(int argc, char** argv)
+{
+  std::cout << "CST builder" << std::endl;
+  if(argc < 2)
+  {
+    std::cout << "Usage: build_cst base_name [block_size [threads]]" << std::endl;
+    return 1;
+  }
+
+  std::string base_name = argv[1];
+  usint block_size = (argc > 2 ? std::max(atoi(argv[2]), 1) : CST::DEFAULT_BLOCK_SIZE);
+  usint threads = (argc > 3 ? std::max(atoi(argv[3]), 1) : 1);
+  std::cout << "Base name: " << base_name << std::endl;
+  std::cout << "Block size: " << block_size << std::endl;
+  std::cout << "Threads: " << threads << std::endl;
+  std::cout << std::endl;
+
+  RLCSA rlcsa(base_name, false);
+  if(!rlcsa.isOk() || !rlcsa.supportsLocate()) { return 2; }
+  rlcsa.reportSize(true);
+
+  std::string plcp_name = base_name + PLCP_EXTENSION;
+  std::ifstream plcp_file(plcp_name.c_str(), std::ios_base::binary);
+  if(!plcp_file)
+  {
+    std::cerr << "Error: Cannot open PLCP file " << plcp_name << "!" << std::endl;
+    return 3;
+  }
+  PLCPVector plcp(plcp_file);
+  plcp_file.close();
+
+  double start = readTimer();
+  CST cst(rlcsa, plcp, block_size, threads);
+  if(!cst.isOk()) { return 4; }
+  cst.writeTo(base_name);
+  double seconds = readTimer() - start;
+
+  std::cout << "PLCP: " << (plcp.reportSize() / (double)MEGABYTE) << " MB" << std::endl;
+  cst.reportSize(true);
+  std::cout << "Time: " << seconds << " seconds" << std::endl;
+  std::cout << std::endl;
+
+  return 0;
+}
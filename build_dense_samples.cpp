@@ -0,0 +1,158 @@
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+#include "rlcsa.h"
+#include "misc/utils.h"
+
+#ifdef MULTITHREAD_SUPPORT
+#include <omp.h>
+#endif
+
+
+using namespace CSA;
+
+
+/*
+  This program builds a layer of dense samples over selected regions of an index.
+  Each line of the region file is either
+
+    sequence rate
+    sequence first last rate
+
+  where first and last are 0-based inclusive offsets in the sequence. The samples
+  are written to base_name.rlcsa.dense_samples, and RLCSA uses them in locate and
+  display after the regular samples. The file starts with RLCSA::getIdentity(), and
+  RLCSA ignores it after the index has been rebuilt or merged.
+*/
+
+
+struct Region
+{
+  usint sequence, rate;
+  pair_type range;  // Absolute text positions.
+};
+
+
+int
+main(int argc, char** argv)
+{
+  std::cout << "Dense sample builder" << std::endl;
+  if(argc < 3)
+  {
+    std::cout << "Usage: build_dense_samples base_name regions [threads]" << std::endl;
+    return 1;
+  }
+
+  std::string base_name = argv[1];
+  usint threads = (argc > 3 ? std::max(atoi(argv[3]), 1) : 1);
+  std::cout << "Base name: " << base_name << std::endl;
+  std::cout << "Regions: " << argv[2] << std::endl;
+  std::cout << "Threads: " << threads << std::endl;
+  std::cout << std::endl;
+
+  Parameters parameters;
+  parameters.set(SAMPLE_RATE);
+  parameters.set(WEIGHTED_SAMPLES);
+  parameters.read(base_name + PARAMETERS_EXTENSION);
+  usint sample_rate = parameters.get(SAMPLE_RATE);
+  bool weighted = parameters.get(WEIGHTED_SAMPLES);
+
+  RLCSA rlcsa(base_name, false);
+  if(!rlcsa.isOk() || !rlcsa.supportsLocate()) { return 2; }
+
+  std::ifstream region_file(argv[2], std::ios_base::binary);
+  if(!region_file)
+  {
+    std::cerr << "Error opening region file!" << std::endl;
+    return 3;
+  }
+  std::vector<std::string> rows;
+  readRows(region_file, rows, true);
+  region_file.close();
+
+  std::vector<Region> regions;
+  for(usint i = 0; i < rows.size(); i++)
+  {
+    std::istringstream fields(rows[i]);
+    std::vector<usint> values; usint value;
+    while(fields >> value) { values.push_back(value); }
+    if((values.size() != 2 && values.size() != 4) || values.back() == 0 || values[0] >= rlcsa.getNumberOfSequences())
+    {
+      std::cerr << "Invalid region: " << rows[i] << std::endl;
+      return 4;
+    }
+
+    Region region;
+    region.sequence = values[0]; region.rate = values.back();
+    region.range = rlcsa.getSequenceRange(region.sequence);
+    if(values.size() == 4)
+    {
+      usint seq_start = region.range.first;
+      region.range.first = std::max(region.range.first, seq_start + values[1]);
+      region.range.second = std::min(region.range.second, seq_start + values[2]);
+    }
+    if(!isEmpty(region.range)) { regions.push_back(region); }
+  }
+
+  // Walk each region with Psi and collect the samples.
+  double start = readTimer();
+  std::vector<std::vector<pair_type> > samples(regions.size());
+  #ifdef MULTITHREAD_SUPPORT
+  omp_set_num_threads(threads);
+  #endif
+  #pragma omp parallel for schedule(dynamic, 1)
+  for(usint i = 0; i < regions.size(); i++)
+  {
+    const Region& region = regions[i];
+    usint index = rlcsa.inverseLocate(region.range.first);
+    for(usint pos = region.range.first; pos <= region.range.second; pos++)
+    {
+      if((pos - region.range.first) % region.rate == 0 && (weighted || pos % sample_rate != 0))
+      {
+        samples[i].push_back(pair_type(index, pos));
+      }
+      if(pos < region.range.second) { index = rlcsa.psi(index); rlcsa.convertToSAIndex(index); }
+    }
+  }
+
+  std::vector<pair_type> all_samples;
+  for(usint i = 0; i < samples.size(); i++)
+  {
+    all_samples.insert(all_samples.end(), samples[i].begin(), samples[i].end());
+    std::vector<pair_type>().swap(samples[i]);
+  }
+  std::sort(all_samples.begin(), all_samples.end());
+  all_samples.erase(std::unique(all_samples.begin(), all_samples.end()), all_samples.end());
+
+  if(all_samples.empty())
+  {
+    std::cerr << "No dense samples!" << std::endl;
+    return 5;
+  }
+
+  std::string sample_name = base_name + DENSE_SAMPLES_EXTENSION;
+  std::ofstream sample_file(sample_name.c_str(), std::ios_base::binary);
+  if(!sample_file)
+  {
+    std::cerr << "Error creating dense sample file!" << std::endl;
+    return 6;
+  }
+  usint identity = rlcsa.getIdentity(), text_size = rlcsa.getTextSize(), items = all_samples.size();
+  sample_file.write((char*)&identity, sizeof(identity));
+  sample_file.write((char*)&text_size, sizeof(text_size));
+  sample_file.write((char*)&items, sizeof(items));
+  sample_file.write((char*)&(all_samples[0]), items * sizeof(pair_type));
+  sample_file.close();
+  double seconds = readTimer() - start;
+
+  std::cout << "Regions: " << regions.size() << std::endl;
+  std::cout << "Dense samples: " << items << std::endl;
+  std::cout << "Time: " << seconds << " seconds" << std::endl;
+  std::cout << std::endl;
+
+  return 0;
+}
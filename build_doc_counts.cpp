@@ -0,0 +1,51 @@
+#include <cstdlib>
+#include <iostream>
+
+#include "rlcsa.h"
+#include "doccounts.h"
+#include "misc/utils.h"
+
+
+using namespace CSA;
+
+
+/*
+  This program builds the document counting structure for top-k document retrieval
+  (doccounts.h). The index must support locate. The structure is written to
+  base_name.rlcsa.doc_counts. Use rlcsa_test -k# to retrieve the top-k documents.
+*/
+
+
+int
+main(int argc, char** argv)
+{
+  std::cout << "Document counting structure builder" << std::endl;
+  if(argc < 2)
+  {
+    std::cout << "Usage: build_doc_counts base_name [threads]" << std::endl;
+    return 1;
+  }
+
+  std::string base_name = argv[1];
+  usint threads = (argc > 2 ? std::max(atoi(argv[2]), 1) : 1);
+  std::cout << "Base name: " << base_name << std::endl;
+  std::cout << "Threads: " << threads << std::endl;
+  std::cout << std::endl;
+
+  RLCSA rlcsa(base_name, false);
+  if(!rlcsa.isOk() || !rlcsa.supportsLocate()) { return 2; }
+  rlcsa.reportSize(true);
+
+  double start = readTimer();
+  DocCounts doc_counts(rlcsa, threads);
+  if(!doc_counts.isOk()) { return 3; }
+  doc_counts.writeTo(base_name);
+  double seconds = readTimer() - start;
+
+  std::cout << "Documents: " << doc_counts.getNumberOfDocuments() << std::endl;
+  doc_counts.reportSize(true);
+  std::cout << "Time: " << seconds << " seconds" << std::endl;
+  std::cout << std::endl;
+
+  return 0;
+}
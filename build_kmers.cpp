@@ -0,0 +1,53 @@
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+
+#include "fmd.h"
+#include "misc/utils.h"
+
+
+using namespace CSA;
+
+
+/*
+  This program builds the k-mer lookup table for an FMD index and writes it
+  next to the index. FMD loads the table automatically when it exists.
+*/
+
+
+int
+main(int argc, char** argv)
+{
+  std::cout << "FMD k-mer table builder" << std::endl;
+  if(argc < 3)
+  {
+    std::cout << "Usage: build_kmers base_name k" << std::endl;
+    return 1;
+  }
+
+  std::string base_name = argv[1];
+  usint k = atoi(argv[2]);
+  std::cout << "Base name: " << base_name << std::endl;
+  std::cout << "k: " << k << std::endl;
+  std::cout << std::endl;
+  if(k == 0 || k > KmerTable::MAX_K)
+  {
+    std::cerr << "Error: k must be between 1 and " << KmerTable::MAX_K << "!" << std::endl;
+    return 2;
+  }
+
+  FMD fmd(base_name);
+  if(!fmd.isOk()) { return 3; }
+
+  double start = readTimer();
+  KmerTable table(fmd, k);
+  if(!table.isOk()) { return 4; }
+  table.writeTo(base_name);
+  double seconds = readTimer() - start;
+
+  std::cout << "Table size: " << (table.reportSize() / (double)MEGABYTE) << " MB" << std::endl;
+  std::cout << "Time: " << seconds << " seconds" << std::endl;
+  std::cout << std::endl;
+
+  return 0;
+}
@@ -0,0 +1,52 @@
+#include <cstdlib>
+#include <iostream>
+
+#include "rlcsa.h"
+#include "runsamples.h"
+#include "misc/utils.h"
+
+
+using namespace CSA;
+
+
+/*
+  This program builds r-index style run-boundary samples for an index that supports
+  locate. The samples are written to base_name.rlcsa.run_samples. Use rlcsa_test -l -R
+  to locate with them.
+*/
+
+
+int
+main(int argc, char** argv)
+{
+  std::cout << "Run sample builder" << std::endl;
+  if(argc < 2)
+  {
+    std::cout << "Usage: build_run_samples base_name [threads]" << std::endl;
+    return 1;
+  }
+
+  std::string base_name = argv[1];
+  usint threads = (argc > 2 ? std::max(atoi(argv[2]), 1) : 1);
+  std::cout << "Base name: " << base_name << std::endl;
+  std::cout << "Threads: " << threads << std::endl;
+  std::cout << std::endl;
+
+  RLCSA rlcsa(base_name, false);
+  if(!rlcsa.isOk() || !rlcsa.supportsLocate()) { return 2; }
+  rlcsa.reportSize(true);
+
+  double start = readTimer();
+  RunSamples run_samples(rlcsa, threads);
+  if(!run_samples.isOk()) { return 3; }
+  run_samples.writeTo(base_name);
+  double seconds = readTimer() - start;
+
+  std::cout << "Runs: " << run_samples.getNumberOfRuns() << std::endl;
+  std::cout << "Phi keys: " << run_samples.getNumberOfKeys() << std::endl;
+  run_samples.reportSize(true);
+  std::cout << "Time: " << seconds << " seconds" << std::endl;
+  std::cout << std::endl;
+
+  return 0;
+}
@@ -0,0 +1,108 @@
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+
+#include "rlcsa.h"
+#include "adaptive_samples.h"
+#include "misc/utils.h"
+
+
+using namespace CSA;
+
+
+/*
+  This program replaces the samples of a single-sequence index with weighted samples
+  placed by WeightedSampler. Every text position gets weight 1, and the positions in the
+  learned adaptive sample tables (written by rlcsa_test -a -A) get additional weight.
+*/
+
+
+void
+printUsage()
+{
+  std::cout << "Usage: compact_samples [parameters] base_name" << std::endl;
+  std::cout << "  -m#  Add # to the weights of learned positions (default: sample rate)." << std::endl;
+  std::cout << "  -t#  Use # threads." << std::endl;
+  std::cout << std::endl;
+}
+
+
+int
+main(int argc, char** argv)
+{
+  std::cout << "Adaptive sample compaction" << std::endl;
+  std::cout << std::endl;
+
+  char* base_name = 0;
+  usint weight = 0, threads = 1;
+  for(int i = 1; i < argc; i++)
+  {
+    if(argv[i][0] == '-')
+    {
+      switch(argv[i][1])
+      {
+        case 'm':
+          weight = atoi(argv[i] + 2); break;
+        case 't':
+          threads = atoi(argv[i] + 2); break;
+        default:
+          std::cout << "Invalid option: " << argv[i] << std::endl << std::endl;
+          printUsage();
+          return 1;
+      }
+    }
+    else if(base_name == 0)
+    {
+      base_name = argv[i];
+    }
+  }
+  if(base_name == 0) { printUsage(); return 2; }
+  threads = std::max(threads, (usint)1);
+
+  Parameters parameters;
+  parameters.set(SAMPLE_RATE);
+  parameters.read(std::string(base_name) + PARAMETERS_EXTENSION);
+  usint sample_rate = parameters.get(SAMPLE_RATE);
+  if(weight == 0) { weight = sample_rate; }
+
+  std::cout << "Base name: " << base_name << std::endl;
+  std::cout << "Sample rate: " << sample_rate << std::endl;
+  std::cout << "Learned weight: " << weight << std::endl;
+  std::cout << "Threads: " << threads << std::endl;
+  std::cout << std::endl;
+
+  RLCSA rlcsa(base_name, false);
+  if(!rlcsa.isOk() || !rlcsa.supportsLocate()) { return 3; }
+  if(rlcsa.getNumberOfSequences() != 1)
+  {
+    std::cerr << "Error: Weighted samples support only one sequence!" << std::endl;
+    return 3;
+  }
+
+  double start = readTimer();
+  usint n = rlcsa.getSize();
+  weight_type* weights = new weight_type[n];
+  for(usint i = 0; i < n; i++) { weights[i] = 1; }
+  {
+    AdaptiveSamples adaptive_samples(rlcsa, base_name);
+    if(!adaptive_samples.isOk()) { delete[] weights; return 4; }
+    if(!adaptive_samples.isWarmStart())
+    {
+      std::cerr << "Error: No learned samples in " << base_name << ADAPTIVE_SAMPLES_EXTENSION << "!" << std::endl;
+      delete[] weights; return 4;
+    }
+    adaptive_samples.report();
+    adaptive_samples.addWeights(weights, weight);
+  }
+
+  WeightedSampler sampler(weights, n, true); weights = 0;
+  if(!(sampler.buildSamples(sample_rate, 0, threads))) { return 5; }
+  if(!(sampler.writeSamples(rlcsa, base_name, threads))) { return 6; }
+  double seconds = readTimer() - start;
+
+  std::cout << "Samples: " << sampler.getItems() << std::endl;
+  std::cout << "Time: " << seconds << " seconds" << std::endl;
+  std::cout << std::endl;
+
+  return 0;
+}
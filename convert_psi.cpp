@@ -0,0 +1,70 @@
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#include "rlcsa.h"
+#include "misc/utils.h"
+
+
+using namespace CSA;
+
+
+/*
+  This program re-encodes the Psi vectors of an existing index. The encoding is given
+  either by name or by number (see PsiVector). With hybrid encoding, the encoding is
+  chosen separately for each character. The index is overwritten, and the encoding is
+  recorded in base_name.rlcsa.parameters.
+*/
+
+
+int
+main(int argc, char** argv)
+{
+  std::cout << "Psi encoding converter" << std::endl;
+  if(argc < 3)
+  {
+    std::cout << "Usage: convert_psi base_name encoding [threads]" << std::endl;
+    std::cout << "Encodings:";
+    for(usint i = 0; i <= PsiVector::HYBRID_ENCODING; i++)
+    {
+      std::cout << " " << PsiVector::encodingName(i) << " (" << i << ")";
+    }
+    std::cout << std::endl;
+    return 1;
+  }
+
+  std::string base_name = argv[1];
+  usint encoding = PsiVector::HYBRID_ENCODING + 1;
+  for(usint i = 0; i <= PsiVector::HYBRID_ENCODING; i++)
+  {
+    if(strcmp(argv[2], PsiVector::encodingName(i)) == 0) { encoding = i; }
+  }
+  if(encoding > PsiVector::HYBRID_ENCODING && argv[2][0] >= '0' && argv[2][0] <= '9') { encoding = atoi(argv[2]); }
+  if(encoding > PsiVector::HYBRID_ENCODING)
+  {
+    std::cerr << "Error: Unknown encoding " << argv[2] << "!" << std::endl;
+    return 1;
+  }
+  usint threads = (argc > 3 ? std::max(atoi(argv[3]), 1) : 1);
+  std::cout << "Base name: " << base_name << std::endl;
+  std::cout << "Encoding: " << PsiVector::encodingName(encoding) << std::endl;
+  std::cout << "Threads: " << threads << std::endl;
+  std::cout << std::endl;
+
+  RLCSA rlcsa(base_name, false);
+  if(!rlcsa.isOk()) { return 2; }
+  rlcsa.printInfo();
+  rlcsa.reportSize(true);
+
+  double start = readTimer();
+  rlcsa.setPsiEncoding(encoding, threads);
+  rlcsa.writeTo(base_name);
+  double seconds = readTimer() - start;
+
+  rlcsa.printInfo();
+  rlcsa.reportSize(true);
+  std::cout << "Time: " << seconds << " seconds" << std::endl;
+  std::cout << std::endl;
+
+  return 0;
+}
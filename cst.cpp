@@ -0,0 +1,503 @@
+#include <algorithm>
+#include <iostream>
+
+#include "cst.h"
+#include "saextractor.h"
+
+#ifdef MULTITHREAD_SUPPORT
+#include <omp.h>
+#endif
+
+
+namespace CSA
+{
+
+
+CST::CST(const RLCSA& _rlcsa, const PLCPVector& _plcp, usint _block_size, usint threads) :
+  rlcsa(_rlcsa), plcp(_plcp),
+  block_size(std::max(_block_size, (usint)1)),
+  ok(false)
+{
+  if(!(this->rlcsa.isOk()) || !(this->rlcsa.supportsLocate()))
+  {
+    std::cerr << "CST: Error: The index does not support locate!" << std::endl;
+    return;
+  }
+
+  // Block minima.
+  usint n = this->getSize();
+  std::vector<usint> minima((n + this->block_size - 1) / this->block_size, ~(usint)0);
+  SAExtractor extractor(this->rlcsa, &(this->plcp), SAExtractor::DEFAULT_BLOCK_SIZE, threads);
+  while(extractor.next())
+  {
+    pair_type range = extractor.getRange();
+    const usint* lcp = extractor.getLCP();
+    for(usint i = range.first; i <= range.second; i++)
+    {
+      usint& block_min = minima[i / this->block_size];
+      block_min = std::min(block_min, lcp[i - range.first]);
+    }
+  }
+
+  // Upper levels.
+  std::vector<std::vector<usint> > values(1);
+  values[0].swap(minima);
+  while(values.rbegin()->size() > BRANCHING)
+  {
+    const std::vector<usint>& prev = *(values.rbegin());
+    std::vector<usint> next((prev.size() + BRANCHING - 1) / BRANCHING, ~(usint)0);
+    for(usint i = 0; i < prev.size(); i++) { next[i / BRANCHING] = std::min(next[i / BRANCHING], prev[i]); }
+    values.push_back(next);
+  }
+
+  usint max_value = 0;
+  for(usint i = 0; i < values[0].size(); i++) { max_value = std::max(max_value, values[0][i]); }
+  usint width = length(max_value);
+  for(usint level = 0; level < values.size(); level++)
+  {
+    WriteBuffer buffer(values[level].size(), width);
+    for(usint i = 0; i < values[level].size(); i++) { buffer.writeItem(values[level][i]); }
+    this->levels.push_back(buffer.getReadBuffer());
+    this->level_sizes.push_back(values[level].size());
+  }
+
+  this->ok = true;
+}
+
+CST::CST(const RLCSA& _rlcsa, const PLCPVector& _plcp, const std::string& base_name) :
+  rlcsa(_rlcsa), plcp(_plcp),
+  block_size(DEFAULT_BLOCK_SIZE),
+  ok(false)
+{
+  std::string input_name = base_name + CST_EXTENSION;
+  std::ifstream input(input_name.c_str(), std::ios_base::binary);
+  if(!input)
+  {
+    std::cerr << "CST: Error opening input file " << input_name << "!" << std::endl;
+    return;
+  }
+
+  usint number_of_levels = 0, width = 0;
+  input.read((char*)&(this->block_size), sizeof(this->block_size));
+  input.read((char*)&number_of_levels, sizeof(number_of_levels));
+  input.read((char*)&width, sizeof(width));
+  for(usint level = 0; level < number_of_levels; level++)
+  {
+    usint size = 0;
+    input.read((char*)&size, sizeof(size));
+    this->levels.push_back(new ReadBuffer(input, size, width));
+    this->level_sizes.push_back(size);
+  }
+  input.close();
+
+  if(number_of_levels == 0 || this->block_size == 0 ||
+     this->level_sizes[0] != (this->getSize() + this->block_size - 1) / this->block_size)
+  {
+    std::cerr << "CST: Error: The structure does not match the index!" << std::endl;
+    return;
+  }
+  this->ok = true;
+}
+
+CST::~CST()
+{
+  for(usint level = 0; level < this->levels.size(); level++)
+  {
+    delete this->levels[level]; this->levels[level] = 0;
+  }
+}
+
+void
+CST::writeTo(const std::string& base_name) const
+{
+  if(!(this->isOk())) { return; }
+
+  std::string output_name = base_name + CST_EXTENSION;
+  std::ofstream output(output_name.c_str(), std::ios_base::binary);
+  if(!output)
+  {
+    std::cerr << "CST: Error creating output file " << output_name << "!" << std::endl;
+    return;
+  }
+
+  usint number_of_levels = this->levels.size();
+  usint width = this->levels[0]->getItemSize();
+  output.write((char*)&(this->block_size), sizeof(this->block_size));
+  output.write((char*)&number_of_levels, sizeof(number_of_levels));
+  output.write((char*)&width, sizeof(width));
+  for(usint level = 0; level < number_of_levels; level++)
+  {
+    output.write((char*)&(this->level_sizes[level]), sizeof(usint));
+    this->levels[level]->writeBuffer(output);
+  }
+  output.close();
+}
+
+usint
+CST::reportSize(bool print) const
+{
+  usint bytes = sizeof(*this) + this->level_sizes.size() * sizeof(usint);
+  for(usint level = 0; level < this->levels.size(); level++)
+  {
+    bytes += this->levels[level]->reportSize();
+  }
+
+  if(print)
+  {
+    std::cout << "CST: " << (bytes / (double)MEGABYTE) << " MB (block size " << this->block_size
+              << ", " << this->levels.size() << " levels)" << std::endl;
+    std::cout << std::endl;
+  }
+
+  return bytes;
+}
+
+//--------------------------------------------------------------------------
+
+usint
+CST::lcp(usint sa_index) const
+{
+  if(sa_index >= this->getSize()) { return 0; }
+
+  usint pos = this->rlcsa.locate(sa_index);
+  PLCPVector::Iterator iter(this->plcp);
+  return iter.select(pos) - 2 * pos;
+}
+
+usint
+CST::rmq(pair_type range) const
+{
+  if(!(this->isOk()) || isEmpty(range) || range.second >= this->getSize()) { return this->getSize(); }
+
+  usint first_block = range.first / this->block_size, last_block = range.second / this->block_size;
+  std::vector<usint> buffer(2 * this->block_size);
+  if(last_block <= first_block + 1)
+  {
+    this->lcpValues(range, &(buffer[0]));
+    return range.first + (sequentialMinElement(buffer.begin(), buffer.begin() + length(range)) - buffer.begin());
+  }
+
+  pair_type first_part(range.first, (first_block + 1) * this->block_size - 1);
+  this->lcpValues(first_part, &(buffer[0]));
+  usint first_pos = sequentialMinElement(buffer.begin(), buffer.begin() + length(first_part)) - buffer.begin();
+  usint first_min = buffer[first_pos];
+
+  pair_type last_part(last_block * this->block_size, range.second);
+  this->lcpValues(last_part, &(buffer[0]));
+  usint last_pos = sequentialMinElement(buffer.begin(), buffer.begin() + length(last_part)) - buffer.begin();
+  usint last_min = buffer[last_pos];
+
+  usint middle_min = this->blockMinimum(pair_type(first_block + 1, last_block - 1));
+  if(first_min <= middle_min && first_min <= last_min) { return first_part.first + first_pos; }
+  if(middle_min > last_min) { return last_part.first + last_pos; }
+
+  // The minimum is in the middle.
+  usint block = this->nextBlock(first_block + 1, middle_min + 1);
+  pair_type block_range(block * this->block_size, (block + 1) * this->block_size - 1);
+  this->lcpValues(block_range, &(buffer[0]));
+  return block_range.first + (sequentialMinElement(buffer.begin(), buffer.begin() + this->block_size) - buffer.begin());
+}
+
+usint
+CST::nextSmaller(usint sa_index, usint value) const
+{
+  if(!(this->isOk()) || sa_index >= this->getSize()) { return this->getSize(); }
+
+  // The rest of the current block. The answer is often close, so the LCP values are
+  // computed in chunks of doubling length.
+  std::vector<usint> buffer(this->block_size);
+  usint block = sa_index / this->block_size;
+  usint block_end = std::min((block + 1) * this->block_size, this->getSize());
+  for(usint i = sa_index, chunk = MIN_CHUNK; i < block_end; i += chunk, chunk *= 2)
+  {
+    pair_type range(i, std::min(i + chunk, block_end) - 1);
+    this->lcpValues(range, &(buffer[0]));
+    for(usint j = 0; j < length(range); j++)
+    {
+      if(buffer[j] < value) { return range.first + j; }
+    }
+  }
+
+  // The first block containing a small enough value.
+  block = this->nextBlock(block + 1, value);
+  if(block >= this->getNumberOfBlocks()) { return this->getSize(); }
+  pair_type range(block * this->block_size, std::min((block + 1) * this->block_size, this->getSize()) - 1);
+  this->lcpValues(range, &(buffer[0]));
+  for(usint i = 0; i < length(range); i++)
+  {
+    if(buffer[i] < value) { return range.first + i; }
+  }
+
+  return this->getSize();
+}
+
+usint
+CST::prevSmaller(usint sa_index, usint value) const
+{
+  if(!(this->isOk()) || sa_index >= this->getSize()) { return this->getSize(); }
+
+  // The beginning of the current block in chunks of doubling length.
+  std::vector<usint> buffer(this->block_size);
+  usint block = sa_index / this->block_size;
+  usint block_start = block * this->block_size;
+  for(usint i = sa_index + 1, chunk = MIN_CHUNK; i > block_start; i -= std::min(chunk, i - block_start), chunk *= 2)
+  {
+    pair_type range(i - std::min(chunk, i - block_start), i - 1);
+    this->lcpValues(range, &(buffer[0]));
+    for(usint j = length(range); j > 0; j--)
+    {
+      if(buffer[j - 1] < value) { return range.first + j - 1; }
+    }
+  }
+
+  // The last block containing a small enough value.
+  if(block == 0) { return this->getSize(); }
+  block = this->prevBlock(block - 1, value);
+  if(block >= this->getNumberOfBlocks()) { return this->getSize(); }
+  pair_type range(block * this->block_size, (block + 1) * this->block_size - 1);
+  this->lcpValues(range, &(buffer[0]));
+  for(usint i = length(range); i > 0; i--)
+  {
+    if(buffer[i - 1] < value) { return range.first + i - 1; }
+  }
+
+  return this->getSize();
+}
+
+//--------------------------------------------------------------------------
+
+usint
+CST::stringDepth(pair_type node) const
+{
+  if(!(this->isOk()) || isEmpty(node) || node.second >= this->getSize()) { return 0; }
+
+  if(this->isLeaf(node))
+  {
+    usint pos = this->rlcsa.locate(node.first);
+    return this->rlcsa.getSequenceRangeForPosition(pos).second - pos + 1;
+  }
+  return this->lcp(this->rmq(pair_type(node.first + 1, node.second)));
+}
+
+pair_type
+CST::parent(pair_type node) const
+{
+  if(!(this->isOk()) || isEmpty(node) || node.second >= this->getSize() || this->isRoot(node)) { return EMPTY_PAIR; }
+
+  usint depth = std::max(this->lcp(node.first), this->lcp(node.second + 1));
+  usint left = this->prevSmaller(node.first, depth);
+  usint right = this->nextSmaller(node.second + 1, depth);
+  return pair_type((left >= this->getSize() ? 0 : left), right - 1);
+}
+
+pair_type
+CST::firstChild(pair_type node) const
+{
+  if(!(this->isOk()) || isEmpty(node) || node.second >= this->getSize() || this->isLeaf(node)) { return EMPTY_PAIR; }
+
+  return pair_type(node.first, this->rmq(pair_type(node.first + 1, node.second)) - 1);
+}
+
+pair_type
+CST::nextSibling(pair_type node) const
+{
+  if(!(this->isOk()) || isEmpty(node) || node.second + 1 >= this->getSize()) { return EMPTY_PAIR; }
+
+  // The sibling exists if LCP[node.second + 1] is the depth of the parent.
+  usint next_lcp = this->lcp(node.second + 1);
+  if(next_lcp < this->lcp(node.first)) { return EMPTY_PAIR; }
+
+  return pair_type(node.second + 1, this->nextSmaller(node.second + 2, next_lcp + 1) - 1);
+}
+
+pair_type
+CST::lca(pair_type a, pair_type b) const
+{
+  if(!(this->isOk()) || isEmpty(a) || isEmpty(b)) { return EMPTY_PAIR; }
+  if(a.second >= this->getSize() || b.second >= this->getSize()) { return EMPTY_PAIR; }
+
+  if(b.first < a.first) { std::swap(a, b); }
+  if(b.second <= a.second) { return a; }
+  if(b.first == a.first) { return b; }
+
+  usint depth = this->lcp(this->rmq(pair_type(a.second + 1, b.first)));
+  usint left = this->prevSmaller(a.first, depth);
+  usint right = this->nextSmaller(b.second + 1, depth);
+  return pair_type((left >= this->getSize() ? 0 : left), right - 1);
+}
+
+pair_type
+CST::suffixLink(pair_type node) const
+{
+  if(!(this->isOk()) || isEmpty(node) || node.second >= this->getSize() || this->isRoot(node)) { return EMPTY_PAIR; }
+
+  usint sequences = this->rlcsa.getNumberOfSequences();
+  if(this->isLeaf(node))
+  {
+    usint next = this->rlcsa.psi(node.first);
+    if(next < sequences) { return EMPTY_PAIR; }
+    return pair_type(next - sequences, next - sequences);
+  }
+
+  usint depth = this->stringDepth(node);
+  if(depth <= 1) { return this->root(); }
+
+  // All suffixes in the node have length >= 2, so Psi maps them to suffixes.
+  usint first = this->rlcsa.psi(node.first) - sequences;
+  usint last = this->rlcsa.psi(node.second) - sequences;
+  usint left = this->prevSmaller(first, depth - 1);
+  usint right = this->nextSmaller(last + 1, depth - 1);
+  return pair_type((left >= this->getSize() ? 0 : left), right - 1);
+}
+
+//--------------------------------------------------------------------------
+
+std::vector<usint>*
+CST::matchingStatistics(const std::string& pattern) const
+{
+  std::vector<usint>* result = new std::vector<usint>(pattern.length(), 0);
+  if(!(this->isOk())) { return result; }
+
+  // Invariant: range is the SA range of pattern[i..i + len - 1].
+  pair_type range = this->root();
+  usint len = 0;
+  for(usint i = pattern.length(); i > 0; i--)
+  {
+    usint c = (uchar)pattern[i - 1];
+    while(true)
+    {
+      pair_type next = range;
+      if(len == 0) { next = this->rlcsa.getCharRange(c); }
+      else
+      {
+        this->rlcsa.convertToBWTRange(next);
+        next = this->rlcsa.LF(next, c);
+      }
+      if(!isEmpty(next))
+      {
+        this->rlcsa.convertToSARange(next);
+        range = next; len++;
+        break;
+      }
+      if(len == 0) { break; }  // The character does not occur.
+
+      // Jump to the parent interval. Its string depth is less than len.
+      len = std::max(this->lcp(range.first), this->lcp(range.second + 1));
+      usint left = this->prevSmaller(range.first, len);
+      range = pair_type((left >= this->getSize() ? 0 : left), this->nextSmaller(range.second + 1, len) - 1);
+    }
+    (*result)[i - 1] = len;
+  }
+
+  return result;
+}
+
+void
+CST::matchingStatistics(const std::vector<std::string>& patterns,
+  std::vector<std::vector<usint> >& results, usint threads) const
+{
+  results.resize(patterns.size());
+
+  #ifdef MULTITHREAD_SUPPORT
+  omp_set_num_threads(std::max(threads, (usint)1));
+  #endif
+  #pragma omp parallel for schedule(dynamic, 1)
+  for(usint i = 0; i < patterns.size(); i++)
+  {
+    std::vector<usint>* ms = this->matchingStatistics(patterns[i]);
+    results[i].swap(*ms);
+    delete ms;
+  }
+}
+
+//--------------------------------------------------------------------------
+
+void
+CST::lcpValues(pair_type range, usint* buffer) const
+{
+  this->rlcsa.locate(range, buffer);
+  PLCPVector::Iterator iter(this->plcp);
+  for(usint i = 0; i < length(range); i++) { buffer[i] = iter.select(buffer[i]) - 2 * buffer[i]; }
+}
+
+usint
+CST::nextBlock(usint block, usint value) const
+{
+  usint level = 0, pos = block;
+  while(true)
+  {
+    if(pos >= this->level_sizes[level]) { return this->getNumberOfBlocks(); }
+    usint group = pos / BRANCHING;
+    usint group_end = std::min((group + 1) * BRANCHING, this->level_sizes[level]);
+    for(; pos < group_end; pos++)
+    {
+      if(this->getBlockMinimum(level, pos) < value) { break; }
+    }
+    if(pos < group_end) { break; }
+    if(level + 1 >= this->levels.size()) { return this->getNumberOfBlocks(); }
+    level++; pos = group + 1;
+  }
+
+  // Descend to the leftmost block with a small enough minimum.
+  while(level > 0)
+  {
+    level--; pos *= BRANCHING;
+    while(this->getBlockMinimum(level, pos) >= value) { pos++; }
+  }
+  return pos;
+}
+
+usint
+CST::prevBlock(usint block, usint value) const
+{
+  usint level = 0, pos = block;
+  while(true)
+  {
+    usint group_start = (pos / BRANCHING) * BRANCHING;
+    bool found = false;
+    for(usint i = pos + 1; i > group_start; i--)
+    {
+      if(this->getBlockMinimum(level, i - 1) < value) { pos = i - 1; found = true; break; }
+    }
+    if(found) { break; }
+    if(group_start == 0 || level + 1 >= this->levels.size()) { return this->getNumberOfBlocks(); }
+    level++; pos = group_start / BRANCHING - 1;
+  }
+
+  // Descend to the rightmost block with a small enough minimum.
+  while(level > 0)
+  {
+    level--; pos = std::min(pos * BRANCHING + BRANCHING, this->level_sizes[level]) - 1;
+    while(this->getBlockMinimum(level, pos) >= value) { pos--; }
+  }
+  return pos;
+}
+
+usint
+CST::blockMinimum(pair_type blocks) const
+{
+  usint result = ~(usint)0;
+  for(usint level = 0; level < this->levels.size() && !isEmpty(blocks); level++)
+  {
+    if(level + 1 >= this->levels.size() || length(blocks) <= 2 * BRANCHING)
+    {
+      for(usint i = blocks.first; i <= blocks.second; i++) { result = std::min(result, this->getBlockMinimum(level, i)); }
+      break;
+    }
+    while(blocks.first % BRANCHING != 0)
+    {
+      result = std::min(result, this->getBlockMinimum(level, blocks.first)); blocks.first++;
+    }
+    while((blocks.second + 1) % BRANCHING != 0)
+    {
+      result = std::min(result, this->getBlockMinimum(level, blocks.second)); blocks.second--;
+    }
+    blocks = pair_type(blocks.first / BRANCHING, blocks.second / BRANCHING);
+  }
+  return result;
+}
+
+//--------------------------------------------------------------------------
+
+
+} // namespace CSA
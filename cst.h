@@ -0,0 +1,145 @@
+#ifndef CST_H
+#define CST_H
+
+#include <fstream>
+#include <vector>
+
+#include "rlcsa.h"
+
+
+namespace CSA
+{
+
+
+const std::string CST_EXTENSION = ".rlcsa.cst";
+
+
+/*
+  A compressed suffix tree layered over RLCSA and PLCP in the style of Fischer, Makinen,
+  and Navarro (Faster entropy-bounded compressed suffix trees, TCS 2009). LCP[i] is
+  computed as PLCP[SA[i]], and range minimum, next smaller value, and previous smaller
+  value queries over the LCP array are supported by a tree of minima of LCP blocks of
+  block_size positions with BRANCHING children per node. The queries scan at most two
+  blocks of LCP values and O(BRANCHING log_BRANCHING(n / block_size)) tree entries.
+
+  Suffix tree nodes are represented as SA ranges. The root is (0, getSize() - 1), and
+  leaf i is (i, i). LCP[0] = 0, and LCP values do not cross sequence boundaries, so the
+  children of the root are the subtrees of the first characters.
+*/
+
+class CST
+{
+  public:
+    const static usint DEFAULT_BLOCK_SIZE = 64;
+    const static usint BRANCHING = 32;
+    const static usint MIN_CHUNK = 4;  // Initial number of LCP values scanned in NSV / PSV.
+
+    // Builds the tree of minima by streaming the LCP array. The index must support
+    // locate. plcp is not owned by the CST.
+    CST(const RLCSA& _rlcsa, const PLCPVector& _plcp, usint _block_size, usint threads);
+    CST(const RLCSA& _rlcsa, const PLCPVector& _plcp, const std::string& base_name);
+    ~CST();
+
+    void writeTo(const std::string& base_name) const;
+    usint reportSize(bool print = false) const;
+
+    inline bool isOk() const { return this->ok; }
+    inline usint getSize() const { return this->rlcsa.getSize(); }
+    inline usint getBlockSize() const { return this->block_size; }
+
+//--------------------------------------------------------------------------
+//  LCP QUERIES
+//--------------------------------------------------------------------------
+
+    // Returns LCP[sa_index].
+    usint lcp(usint sa_index) const;
+
+    // Returns the leftmost position of the minimum value in LCP[range].
+    usint rmq(pair_type range) const;
+
+    // Returns the smallest j >= sa_index with LCP[j] < value, or getSize() if none exists.
+    usint nextSmaller(usint sa_index, usint value) const;
+
+    // Returns the largest j <= sa_index with LCP[j] < value, or getSize() if none exists.
+    usint prevSmaller(usint sa_index, usint value) const;
+
+//--------------------------------------------------------------------------
+//  SUFFIX TREE OPERATIONS
+//--------------------------------------------------------------------------
+
+    inline pair_type root() const { return pair_type(0, this->getSize() - 1); }
+    inline bool isRoot(pair_type node) const { return (node == this->root()); }
+    inline bool isLeaf(pair_type node) const { return (node.first == node.second); }
+
+    // The length of the string corresponding to the node. For leaves, this is the length
+    // of the suffix within its sequence.
+    usint stringDepth(pair_type node) const;
+
+    // These return EMPTY_PAIR if the node does not exist.
+    pair_type parent(pair_type node) const;
+    pair_type firstChild(pair_type node) const;
+    pair_type nextSibling(pair_type node) const;
+
+    // Lowest common ancestor.
+    pair_type lca(pair_type a, pair_type b) const;
+
+    // If the node corresponds to string aX, returns the node corresponding to X. The suffix
+    // link of a node of depth 1 is the root. Returns EMPTY_PAIR for the root and for leaves
+    // of length 1.
+    pair_type suffixLink(pair_type node) const;
+
+//--------------------------------------------------------------------------
+//  MATCHING STATISTICS
+//--------------------------------------------------------------------------
+
+    // Returns MS[i] = the length of the longest prefix of pattern[i..] that occurs in the
+    // collection. Backward search extends the match to the left, and when it fails, the
+    // match is shortened by jumping to the parent interval. The total number of parent
+    // jumps is at most the length of the pattern. User must free the returned vector.
+    std::vector<usint>* matchingStatistics(const std::string& pattern) const;
+
+    // Processes the patterns in parallel. results[i] will be the matching statistics of
+    // patterns[i].
+    void matchingStatistics(const std::vector<std::string>& patterns,
+      std::vector<std::vector<usint> >& results, usint threads) const;
+
+  private:
+    const RLCSA&      rlcsa;
+    const PLCPVector& plcp;
+    usint             block_size;
+
+    // levels[0][b] is the minimum of block b of LCP. levels[l + 1][b] is the minimum of
+    // levels[l][b * BRANCHING] to levels[l][(b + 1) * BRANCHING - 1].
+    std::vector<ReadBuffer*> levels;
+    std::vector<usint>       level_sizes;
+
+    bool ok;
+
+    // Writes LCP[range] to buffer.
+    void lcpValues(pair_type range, usint* buffer) const;
+
+    // The smallest / largest block at level 0 with minimum < value starting from block.
+    // Return getNumberOfBlocks() if none exists.
+    usint nextBlock(usint block, usint value) const;
+    usint prevBlock(usint block, usint value) const;
+
+    // Minimum of the blocks in the closed range.
+    usint blockMinimum(pair_type blocks) const;
+
+    inline usint getNumberOfBlocks() const { return this->level_sizes[0]; }
+    inline usint getBlockMinimum(usint level, usint block) const
+    {
+      return this->levels[level]->readItemConst(block);
+    }
+
+    // These are not allowed.
+    CST();
+    CST(const CST&);
+    CST& operator = (const CST&);
+};
+
+
+} // namespace CSA
+
+
+#endif // CST_H
@@ -0,0 +1,147 @@
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#include "rlcsa.h"
+#include "cst.h"
+#include "misc/utils.h"
+
+
+using namespace CSA;
+
+
+/*
+  This program checks the range minimum queries and the child and sibling operations of
+  the compressed suffix tree against a brute force scan of the LCP array. The tree of
+  minima is built in memory with the given block size, so large blocks can be tested
+  without rebuilding the .rlcsa.cst file. The PLCP must have been built with build_plcp.
+  The queries run with the given number of threads available to libstdc++ Parallel Mode,
+  which is used for large buffers.
+*/
+
+
+usint leftmostMinimum(const std::vector<usint>& lcp, pair_type range);
+
+
+int
+main(int argc, char** argv)
+{
+  std::cout << "CST test" << std::endl;
+  if(argc < 2)
+  {
+    std::cout << "Usage: cst_test base_name [block_size [queries [threads]]]" << std::endl;
+    return 1;
+  }
+
+  std::string base_name = argv[1];
+  usint block_size = (argc > 2 ? std::max(atoi(argv[2]), 1) : 4096);
+  usint queries = (argc > 3 ? atoi(argv[3]) : 1000);
+  usint threads = (argc > 4 ? std::max(atoi(argv[4]), 1) : 4);
+  std::cout << "Base name: " << base_name << std::endl;
+  std::cout << "Block size: " << block_size << std::endl;
+  std::cout << "Queries: " << queries << std::endl;
+  std::cout << "Threads: " << threads << std::endl;
+  std::cout << std::endl;
+
+  RLCSA rlcsa(base_name, false);
+  if(!rlcsa.isOk() || !rlcsa.supportsLocate()) { return 2; }
+
+  std::string plcp_name = base_name + PLCP_EXTENSION;
+  std::ifstream plcp_file(plcp_name.c_str(), std::ios_base::binary);
+  if(!plcp_file)
+  {
+    std::cerr << "Error: Cannot open PLCP file " << plcp_name << "!" << std::endl;
+    return 3;
+  }
+  PLCPVector plcp(plcp_file);
+  plcp_file.close();
+
+  CST cst(rlcsa, plcp, block_size, threads);
+  if(!cst.isOk()) { return 4; }
+
+  usint n = cst.getSize();
+  std::vector<usint> lcp(n + 1, 0);
+  for(usint i = 0; i < n; i++) { lcp[i] = cst.lcp(i); }
+
+  // Range minimum queries spanning up to four blocks.
+  std::srand(0xDEADBEEF);
+  double start = readTimer();
+  usint rmq_failures = 0;
+  for(usint i = 0; i < queries; i++)
+  {
+    usint first = std::rand() % n;
+    usint len = 1 + std::rand() % std::min(4 * block_size, n - first);
+    pair_type range(first, first + len - 1);
+    usint expected = leftmostMinimum(lcp, range);
+    usint found = cst.rmq(range);
+    if(found != expected)
+    {
+      if(rmq_failures < 10)
+      {
+        std::cerr << "Error: rmq(" << range.first << ", " << range.second << ") = " << found
+                  << ", expected " << expected << "!" << std::endl;
+      }
+      rmq_failures++;
+    }
+  }
+  double rmq_time = readTimer() - start;
+
+  // The children of an internal node (l, r) with string depth d are separated by the
+  // positions j in (l, r] with LCP[j] = d. Check all ancestors of random leaves, as the
+  // nodes close to the root contain many ties for the minimum.
+  start = readTimer();
+  usint child_failures = 0, nodes = 0;
+  for(usint i = 0; i < queries / 10; i++)
+  {
+    pair_type node(std::rand() % n, 0); node.second = node.first;
+    while(!cst.isRoot(node))
+    {
+      node = cst.parent(node);
+      if(isEmpty(node)) { break; }
+      nodes++;
+
+      usint depth = lcp[leftmostMinimum(lcp, pair_type(node.first + 1, node.second))];
+      bool ok = true;
+      pair_type child = cst.firstChild(node);
+      usint child_start = node.first;
+      for(usint j = node.first + 1; j <= node.second + 1; j++)
+      {
+        if(j <= node.second && lcp[j] != depth) { continue; }
+        if(child != pair_type(child_start, j - 1)) { ok = false; break; }
+        child = cst.nextSibling(child);
+        child_start = j;
+      }
+      if(child != EMPTY_PAIR) { ok = false; }  // The last child has no next sibling.
+      if(!ok)
+      {
+        if(child_failures < 10)
+        {
+          std::cerr << "Error: Wrong children for node (" << node.first << ", " << node.second << ")!" << std::endl;
+        }
+        child_failures++;
+      }
+    }
+  }
+  double child_time = readTimer() - start;
+
+  std::cout << "rmq: " << queries << " queries in " << rmq_time << " seconds, "
+            << rmq_failures << " failures" << std::endl;
+  std::cout << "Children: " << nodes << " nodes in " << child_time << " seconds, "
+            << child_failures << " failures" << std::endl;
+  std::cout << std::endl;
+
+  return (rmq_failures > 0 || child_failures > 0 ? 5 : 0);
+}
+
+
+usint
+leftmostMinimum(const std::vector<usint>& lcp, pair_type range)
+{
+  usint pos = range.first;
+  for(usint i = range.first + 1; i <= range.second; i++)
+  {
+    if(lcp[i] < lcp[pos]) { pos = i; }
+  }
+  return pos;
+}
@@ -2,8 +2,10 @@
 #include <cstdlib>
 #include <fstream>
 #include <iostream>
+#include <vector>
 
 #include "rlcsa.h"
+#include "adaptive_samples.h"
 #include "sampler.h"
 #include "misc/utils.h"
 
@@ -11,37 +13,109 @@
 using namespace CSA;
 
 
+// Returns the number of wrong results.
+usint
+checkAdaptive(RLCSA& rlcsa, const std::string& base_name, usint sequences, usint seq_length)
+{
+  AdaptiveSamples samples(rlcsa, base_name);
+  if(!samples.isOk() || !samples.supportsDisplay())
+  {
+    std::cerr << "Error: Adaptive display requires HALF_GREEDY_SAMPLES = 1!" << std::endl;
+    return 1;
+  }
+
+  uchar* buffer = new uchar[seq_length];
+  uchar* expected = new uchar[seq_length];
+  usint inside = 0, crossing = 0, wrong = 0;
+  for(usint i = 0; i < sequences; i++)
+  {
+    usint sequence = rand() % rlcsa.getNumberOfSequences();
+    pair_type seq_range = rlcsa.getSequenceRange(sequence);
+
+    // A range within the sequence must match RLCSA::display().
+    if(length(seq_range) >= seq_length)
+    {
+      usint offset = rand() % (length(seq_range) - seq_length + 1);
+      pair_type range(offset, offset + seq_length - 1);
+      rlcsa.display(sequence, range, expected);
+      range.first += seq_range.first; range.second += seq_range.first;
+      samples.display(range, buffer);
+      if(!std::equal(buffer, buffer + seq_length, expected)) { wrong++; }
+      inside++;
+    }
+
+    // A range crossing the end of the sequence must be rejected without writing anything.
+    usint max_overlap = std::min(seq_length - 1, length(seq_range));
+    if(max_overlap > 0)
+    {
+      pair_type range(seq_range.second + 1 - (1 + rand() % max_overlap), 0);
+      range.second = range.first + seq_length - 1;
+      if(range.second >= rlcsa.getTextSize()) { continue; }
+      std::fill(buffer, buffer + seq_length, 0xFF);
+      samples.display(range, buffer);
+      if(std::count(buffer, buffer + seq_length, 0xFF) != (std::ptrdiff_t)seq_length) { wrong++; }
+      crossing++;
+    }
+  }
+  delete[] buffer; delete[] expected;
+
+  std::cout << "Adaptive display: " << inside << " ranges within sequences, " << crossing
+            << " crossing the end, " << wrong << " wrong" << std::endl;
+  std::cout << std::endl;
+  return wrong;
+}
+
+
 usint*
 generatePositions(weight_type* weights, usint size, usint number);
 
+void
+benchmark(RLCSA& rlcsa, usint* positions, usint sequences, usint seq_length, bool direct);
+
+usint
+checkAdaptive(RLCSA& rlcsa, const std::string& base_name, usint sequences, usint seq_length);
+
 int main(int argc, char** argv)
 {
   std::cout << "RLCSA display test" << std::endl;
-  if(argc < 5)
+  bool compare = false, adaptive = false;
+  std::vector<char*> args;
+  for(int i = 1; i < argc; i++)
   {
-    std::cout << "Usage: display_test basename weights sequences length [random_seed]" << std::endl;
+    if(argv[i][0] == '-' && argv[i][1] == 'b') { compare = true; }
+    else if(argv[i][0] == '-' && argv[i][1] == 'a') { adaptive = true; }
+    else { args.push_back(argv[i]); }
+  }
+  if(args.size() < 4)
+  {
+    std::cout << "Usage: display_test [-a] [-b] basename weights sequences length [random_seed]" << std::endl;
+    std::cout << "  -a   Check half-greedy adaptive display against the index at random sequence" << std::endl;
+    std::cout << "       offsets, including ranges that cross the end of a sequence." << std::endl;
+    std::cout << "  -b   Compare the direct and compact layouts of inverse SA samples." << std::endl;
     return 1;
   }
   std::cout << std::endl;
 
-  std::cout << "Base name: " << argv[1] << std::endl;
-  std::cout << "Weights: " << argv[2] << std::endl; 
+  std::cout << "Base name: " << args[0] << std::endl;
+  std::cout << "Weights: " << args[1] << std::endl; 
 
-  usint sequences = std::max(atoi(argv[3]), 1);
+  usint sequences = std::max(atoi(args[2]), 1);
   std::cout << "Sequences: " << sequences << std::endl;
 
-  usint seq_length = std::max(atoi(argv[4]), 1);
+  usint seq_length = std::max(atoi(args[3]), 1);
   std::cout << "Sequence length: " << seq_length << std::endl;
 
   usint seed = 0xDEADBEEF;
-  if(argc > 5)
+  if(args.size() > 4)
   {
-    seed = atoi(argv[5]);
+    seed = atoi(args[4]);
   }
   std::cout << "Random seed: " << seed << std::endl; 
+  if(compare) { std::cout << "Mode: compare inverse sample layouts" << std::endl; }
+  if(adaptive) { std::cout << "Mode: check adaptive display" << std::endl; }
   std::cout << std::endl;
 
-  RLCSA rlcsa(argv[1]);
+  RLCSA rlcsa(args[0]);
   if(!rlcsa.isOk() || !rlcsa.supportsDisplay())
   {
     std::cerr << "Error: Display is not supported!" << std::endl;
@@ -51,10 +125,16 @@ int main(int argc, char** argv)
   rlcsa.reportSize(true);
   usint size = rlcsa.getSize();
 
+  if(adaptive)
+  {
+    srand(seed);
+    return (checkAdaptive(rlcsa, args[0], sequences, seq_length) > 0 ? 4 : 0);
+  }
+
 
   // Read weights and determine positions.
   weight_type* weights = new weight_type[size];
-  std::ifstream weight_file(argv[2], std::ios_base::binary);
+  std::ifstream weight_file(args[1], std::ios_base::binary);
   if(!weight_file)
   {
     std::cerr << "Error: Cannot open weight file!" << std::endl;
@@ -71,6 +151,14 @@ int main(int argc, char** argv)
 
 
   // Do & measure the actual work.
+  if(compare)
+  {
+    benchmark(rlcsa, positions, sequences, seq_length, false);
+    benchmark(rlcsa, positions, sequences, seq_length, true);
+    delete[] positions;
+    return 0;
+  }
+
   uchar* buffer = new uchar[seq_length];
   double start = readTimer();
   for(usint i = 0; i < sequences; i++)
@@ -88,6 +176,38 @@ int main(int argc, char** argv)
 }
 
 
+void
+benchmark(RLCSA& rlcsa, usint* positions, usint sequences, usint seq_length, bool direct)
+{
+  rlcsa.setDirectInverseSamples(direct);
+  std::cout << (direct ? "Direct" : "Compact") << " inverse samples:" << std::endl;
+  std::cout << "  Index size:     " << (rlcsa.reportSize() / (double)MEGABYTE) << " MB" << std::endl;
+
+  usint checksum = 0;
+  double start = readTimer();
+  for(usint i = 0; i < sequences; i++)
+  {
+    checksum += rlcsa.inverseLocate(positions[i]);
+  }
+  double time = readTimer() - start;
+  std::cout << "  inverseLocate:  " << time << " seconds (" << (sequences / time) << " / sec)" << std::endl;
+
+  uchar* buffer = new uchar[seq_length];
+  start = readTimer();
+  for(usint i = 0; i < sequences; i++)
+  {
+    rlcsa.display(0, pair_type(positions[i], positions[i] + seq_length - 1), buffer);
+    checksum += buffer[0];
+  }
+  time = readTimer() - start;
+  std::cout << "  display:        " << time << " seconds (" << (sequences / time) << " / sec)" << std::endl;
+  std::cout << "  Checksum:       " << checksum << std::endl;
+  std::cout << std::endl;
+
+  delete[] buffer;
+}
+
+
 usint*
 generatePositions(weight_type* weights, usint size, usint number)
 {
@@ -543,6 +543,253 @@ DocArray::readRules(const std::string& name_prefix, bool print)
 
 
   // Build the structures.
+  usint real_occs = this->buildGrammar(occurrences, docs, rb_encoder, rb_encoder_rle, total_size);
+
+  if(print)
+  {
+    std::cout << files << " files: "
+      << total_rules << " rules, "
+      << total_occs << " occurrences, "
+      << total_size << " document ids in "
+      << total_runs << " runs, "
+      << total_singletons << " singletons, "
+      << (real_occs - total_occs - total_singletons) << " complete blocks" << std::endl;
+    if(this->usesRLE()) { std::cout << "Using run-length encoded rules." << std::endl; }
+    std::cout << std::endl;
+  }
+}
+
+//--------------------------------------------------------------------------
+
+/*
+  Approximate Re-Pair over sorted document sets. Symbols below 'documents' are document ids,
+  and symbol documents + i is rule i = (rules[i].first, rules[i].second). In each round, the
+  pairs of adjacent symbols are counted in parallel, and every pair occurring at least
+  max(2, max_frequency / 2) times becomes a rule. The sets are then scanned left to right in
+  parallel, replacing the selected pairs greedily. Returns the number of rounds.
+*/
+usint
+repairSets(std::vector<std::vector<usint> >& sets, usint documents, std::vector<pair_type>& rules, usint threads)
+{
+  usint parts = std::max((usint)1, std::min(threads, (usint)(sets.size())));
+  usint rounds = 0;
+  #ifdef MULTITHREAD_SUPPORT
+  omp_set_num_threads(threads);
+  #endif
+
+  while(true)
+  {
+    // Count the pairs.
+    std::vector<std::vector<pair_type> > part_pairs(parts);
+    #pragma omp parallel for schedule(dynamic, 1)
+    for(usint part = 0; part < parts; part++)
+    {
+      usint from = (part * sets.size()) / parts, to = ((part + 1) * sets.size()) / parts;
+      for(usint i = from; i < to; i++)
+      {
+        for(usint j = 1; j < sets[i].size(); j++)
+        {
+          part_pairs[part].push_back(pair_type(sets[i][j - 1], sets[i][j]));
+        }
+      }
+    }
+    std::vector<pair_type> pairs;
+    for(usint part = 0; part < parts; part++)
+    {
+      pairs.insert(pairs.end(), part_pairs[part].begin(), part_pairs[part].end());
+      std::vector<pair_type>().swap(part_pairs[part]);
+    }
+    parallelSort(pairs.begin(), pairs.end());
+
+    // Select the pairs. They remain sorted, so rule first_rule + i is selected[i].
+    std::vector<usint> frequencies;
+    usint tail = 0, max_frequency = 0;
+    for(usint i = 0; i < pairs.size(); )
+    {
+      usint j = i + 1;
+      while(j < pairs.size() && pairs[j] == pairs[i]) { j++; }
+      if(j - i >= 2)
+      {
+        pairs[tail] = pairs[i]; tail++;
+        frequencies.push_back(j - i); max_frequency = std::max(max_frequency, j - i);
+      }
+      i = j;
+    }
+    pairs.resize(tail);
+    usint threshold = std::max((usint)2, max_frequency / 2);
+    tail = 0;
+    for(usint i = 0; i < pairs.size(); i++)
+    {
+      if(frequencies[i] >= threshold) { pairs[tail] = pairs[i]; tail++; }
+    }
+    pairs.resize(tail);
+    if(pairs.empty()) { break; }
+    usint first_rule = documents + rules.size();
+    rules.insert(rules.end(), pairs.begin(), pairs.end());
+
+    // Replace the pairs.
+    #pragma omp parallel for schedule(dynamic, 1)
+    for(usint part = 0; part < parts; part++)
+    {
+      usint from = (part * sets.size()) / parts, to = ((part + 1) * sets.size()) / parts;
+      for(usint i = from; i < to; i++)
+      {
+        std::vector<usint>& set = sets[i];
+        usint set_tail = 0;
+        for(usint j = 0; j < set.size(); j++, set_tail++)
+        {
+          if(j + 1 < set.size())
+          {
+            pair_type pair(set[j], set[j + 1]);
+            std::vector<pair_type>::iterator iter = std::lower_bound(pairs.begin(), pairs.end(), pair);
+            if(iter != pairs.end() && *iter == pair)
+            {
+              set[set_tail] = first_rule + (iter - pairs.begin()); j++;
+              continue;
+            }
+          }
+          set[set_tail] = set[j];
+        }
+        set.resize(set_tail);
+      }
+    }
+    rounds++;
+  }
+
+  return rounds;
+}
+
+// Appends the document ids generated by the symbol to the result.
+void
+expandSymbol(usint symbol, usint documents, const std::vector<pair_type>& rules, std::vector<usint>& result)
+{
+  std::stack<usint> symbols; symbols.push(symbol);
+  while(!(symbols.empty()))
+  {
+    usint curr = symbols.top(); symbols.pop();
+    if(curr < documents) { result.push_back(curr); continue; }
+    symbols.push(rules[curr - documents].second);
+    symbols.push(rules[curr - documents].first);
+  }
+}
+
+void
+DocArray::buildRules(std::vector<std::pair<usint, std::vector<usint> > >& sets, usint threads, bool print)
+{
+  usint documents = this->getNumberOfDocuments();
+  threads = std::max(threads, (usint)1);
+
+  std::vector<std::vector<usint> > symbols(sets.size());
+  std::vector<usint> set_blocks(sets.size());
+  usint total_docs = 0;
+  for(usint i = 0; i < sets.size(); i++)
+  {
+    set_blocks[i] = sets[i].first;
+    symbols[i].swap(sets[i].second);
+    total_docs += symbols[i].size();
+  }
+  sets.clear();
+
+  std::vector<pair_type> repair_rules;
+  usint rounds = repairSets(symbols, documents, repair_rules, threads);
+
+  // Rules occurring at least twice in the sets are stored. The rest are expanded.
+  std::vector<usint> rule_ids(repair_rules.size(), 0);
+  for(usint i = 0; i < symbols.size(); i++)
+  {
+    for(std::vector<usint>::iterator iter = symbols[i].begin(); iter != symbols[i].end(); ++iter)
+    {
+      if(*iter >= documents) { rule_ids[*iter - documents]++; }
+    }
+  }
+  std::vector<usint> stored_rules;
+  for(usint i = 0; i < repair_rules.size(); i++)
+  {
+    if(rule_ids[i] >= 2) { rule_ids[i] = documents + stored_rules.size(); stored_rules.push_back(i); }
+    else { rule_ids[i] = 0; }
+  }
+
+  // Encode the stored rules.
+  std::vector<usint> docs;
+  SuccinctVector::Encoder rb_encoder(RULE_BLOCK_SIZE);
+  SuccinctVector::Encoder rb_encoder_rle(RULE_BLOCK_SIZE);
+  usint total_size = 0, total_runs = 0;
+  for(std::vector<usint>::iterator iter = stored_rules.begin(); iter != stored_rules.end(); ++iter)
+  {
+    std::vector<usint> rule_docs;
+    expandSymbol(documents + *iter, documents, repair_rules, rule_docs);
+    rb_encoder.addBit(total_size);
+    rb_encoder_rle.addBit(docs.size());
+    usint prev_doc = WORD_MAX - 1, run_length = 0;
+    for(std::vector<usint>::iterator doc = rule_docs.begin(); doc != rule_docs.end(); ++doc)
+    {
+      if(*doc == prev_doc + 1) { run_length++; prev_doc++; }
+      else
+      {
+        if(run_length > 0) { docs.push_back(run_length); }
+        docs.push_back(*doc); run_length = 1; total_runs++;
+        prev_doc = *doc;
+      }
+    }
+    docs.push_back(run_length);
+    total_size += rule_docs.size();
+  }
+  if(stored_rules.empty())  // Rule borders cannot be empty, so add an unused rule.
+  {
+    rb_encoder.addBit(0); rb_encoder_rle.addBit(0);
+    docs.push_back(documents);
+    total_size++; total_runs++;
+  }
+
+  // Blocks.
+  std::vector<pair_type> occurrences; // (block_id, rule_id / doc_id)
+  usint total_occs = 0, total_singletons = 0;
+  for(usint i = 0; i < symbols.size(); i++)
+  {
+    for(std::vector<usint>::iterator iter = symbols[i].begin(); iter != symbols[i].end(); ++iter)
+    {
+      if(*iter < documents)
+      {
+        occurrences.push_back(pair_type(set_blocks[i], *iter)); total_singletons++;
+      }
+      else if(rule_ids[*iter - documents] != 0)
+      {
+        occurrences.push_back(pair_type(set_blocks[i], rule_ids[*iter - documents])); total_occs++;
+      }
+      else
+      {
+        std::vector<usint> rule_docs;
+        expandSymbol(*iter, documents, repair_rules, rule_docs);
+        for(std::vector<usint>::iterator doc = rule_docs.begin(); doc != rule_docs.end(); ++doc)
+        {
+          occurrences.push_back(pair_type(set_blocks[i], *doc)); total_singletons++;
+        }
+      }
+    }
+    std::vector<usint>().swap(symbols[i]);
+  }
+
+  usint real_occs = this->buildGrammar(occurrences, docs, rb_encoder, rb_encoder_rle, total_size);
+
+  if(print)
+  {
+    std::cout << "Re-Pair: " << set_blocks.size() << " sets with " << total_docs << " document ids, "
+      << rounds << " rounds, " << repair_rules.size() << " rules" << std::endl;
+    std::cout << stored_rules.size() << " stored rules, "
+      << total_occs << " occurrences, "
+      << total_size << " document ids in "
+      << total_runs << " runs, "
+      << total_singletons << " singletons, "
+      << (real_occs - total_occs - total_singletons) << " complete blocks" << std::endl;
+    if(this->usesRLE()) { std::cout << "Using run-length encoded rules." << std::endl; }
+    std::cout << std::endl;
+  }
+}
+
+usint
+DocArray::buildGrammar(std::vector<pair_type>& occurrences, std::vector<usint>& docs,
+  SuccinctVector::Encoder& rb_encoder, SuccinctVector::Encoder& rb_encoder_rle, usint total_size)
+{
   if(total_size < docs.size())
   {
     this->uses_rle = false;
@@ -584,7 +831,8 @@ DocArray::readRules(const std::string& name_prefix, bool print)
     while(looking_for < occurrences[i].first) { real_occs++; looking_for++; }
     looking_for = occurrences[i].first + 1;
   }
-  real_occs += this->getNumberOfNodes() - 1 - occurrences.rbegin()->first;
+  usint first_unused = (occurrences.empty() ? 0 : occurrences.rbegin()->first + 1);
+  real_occs += this->getNumberOfNodes() - first_unused;
 
   SuccinctVector::Encoder bb_encoder(BLOCK_BLOCK_SIZE);
   WriteBuffer bbuf(real_occs, length(this->maxInteger()));
@@ -604,7 +852,7 @@ DocArray::readRules(const std::string& name_prefix, bool print)
     }
     bbuf.writeItem(occurrences[i].second); pos++;
   }
-  for(usint i = occurrences.rbegin()->first + 1; i < this->getNumberOfNodes(); i++)
+  for(usint i = first_unused; i < this->getNumberOfNodes(); i++)
   {
     bb_encoder.addBit(pos);
     bbuf.writeItem(this->maxInteger()); pos++;
@@ -612,19 +860,8 @@ DocArray::readRules(const std::string& name_prefix, bool print)
   this->block_borders = new SuccinctVector(bb_encoder, real_occs);
   this->blocks = bbuf.getReadBuffer();
 
-  if(print)
-  {
-    std::cout << files << " files: "
-      << total_rules << " rules, "
-      << total_occs << " occurrences, "
-      << total_size << " document ids in "
-      << total_runs << " runs, "
-      << total_singletons << " singletons, "
-      << (real_occs - total_occs - total_singletons) << " complete blocks" << std::endl;
-    if(this->usesRLE()) { std::cout << "Using run-length encoded rules." << std::endl; }
-    std::cout << std::endl;
-  }
   this->has_grammar = true;
+  return real_occs;
 }
 
 //--------------------------------------------------------------------------
@@ -751,6 +988,34 @@ DocArray::directListingRLE(pair_type range) const
   return result;
 }
 
+std::vector<usint>*
+DocArray::listDocuments(pair_type range, usint threads) const
+{
+  if(isEmpty(range) || range.second >= this->getSize()) { return 0; }
+  return this->parallelListing<usint>(range, threads, false);
+}
+
+std::vector<pair_type>*
+DocArray::listDocumentsRLE(pair_type range, usint threads) const
+{
+  if(isEmpty(range) || range.second >= this->getSize()) { return 0; }
+  return this->parallelListing<pair_type>(range, threads, false);
+}
+
+std::vector<usint>*
+DocArray::directListing(pair_type range, usint threads) const
+{
+  if(isEmpty(range) || range.second >= this->getSize()) { return 0; }
+  return this->parallelListing<usint>(range, threads, true);
+}
+
+std::vector<pair_type>*
+DocArray::directListingRLE(pair_type range, usint threads) const
+{
+  if(isEmpty(range) || range.second >= this->getSize()) { return 0; }
+  return this->parallelListing<pair_type>(range, threads, true);
+}
+
 //--------------------------------------------------------------------------
 
 } // namespace CSA
@@ -6,6 +6,10 @@
 
 #include "rlcsa.h"
 
+#ifdef MULTITHREAD_SUPPORT
+#include <omp.h>
+#endif
+
 
 namespace CSA
 {
@@ -60,6 +64,11 @@ class DocArray
 
     void readRules(const std::string& name_prefix, bool print = false);
 
+    // Builds the grammar in-process using Re-Pair over the stored document sets instead of
+    // reading external rule files. Each set is (block id, sorted 0-based document ids) and
+    // the blocks without a set contain all documents. The sets are consumed.
+    void buildRules(std::vector<std::pair<usint, std::vector<usint> > >& sets, usint threads, bool print = false);
+
     void writeTo(const std::string& base_name) const;
     usint reportSize(bool print = false) const;
 
@@ -74,6 +83,15 @@ class DocArray
     std::vector<usint>* directListing(pair_type range) const;
     std::vector<pair_type>* directListingRLE(pair_type range) const;
 
+    // Multithreaded versions. The range is split into at most 'threads' parts of at least
+    // MIN_PARALLEL_RANGE suffixes, and the sorted results for the parts are merged.
+    std::vector<usint>* listDocuments(pair_type range, usint threads) const;
+    std::vector<pair_type>* listDocumentsRLE(pair_type range, usint threads) const;
+    std::vector<usint>* directListing(pair_type range, usint threads) const;
+    std::vector<pair_type>* directListingRLE(pair_type range, usint threads) const;
+
+    const static usint MIN_PARALLEL_RANGE = 4096;
+
     inline bool isOk() const { return this->ok; }
     inline bool hasGrammar() const { return this->has_grammar; }
     inline bool usesRLE() const { return this->uses_rle; }
@@ -133,6 +151,11 @@ class DocArray
 
     const static usint RLE_FLAG = 0x01;
 
+    // Builds rule_borders, rules, block_borders, and blocks from the encoded rules and
+    // (block_id, rule_id / doc_id) pairs. Returns the number of items in the blocks.
+    usint buildGrammar(std::vector<pair_type>& occurrences, std::vector<usint>& docs,
+      SuccinctVector::Encoder& rb_encoder, SuccinctVector::Encoder& rb_encoder_rle, usint total_size);
+
 //--------------------------------------------------------------------------
 
     template<class T>
@@ -257,6 +280,48 @@ class DocArray
       return false;
     }
 
+    template<class T>
+    std::vector<T>*
+    parallelListing(pair_type range, usint threads, bool direct) const
+    {
+      usint parts = std::max((usint)1, std::min(threads, length(range) / MIN_PARALLEL_RANGE));
+      std::vector<std::vector<T>*> results(parts, (std::vector<T>*)0);
+
+      #ifdef MULTITHREAD_SUPPORT
+      omp_set_num_threads(threads);
+      #endif
+      #pragma omp parallel for schedule(dynamic, 1)
+      for(usint i = 0; i < parts; i++)
+      {
+        pair_type part(range.first + (i * length(range)) / parts, range.first + ((i + 1) * length(range)) / parts - 1);
+        if(direct) { results[i] = new std::vector<T>; this->processRange(part, *(results[i])); }
+        else       { results[i] = this->documentListing<T>(part); }
+        sequentialSort(results[i]->begin(), results[i]->end());
+        this->compactSorted(*(results[i]));
+      }
+
+      // Merge the sorted parts pairwise.
+      std::vector<T>* result = new std::vector<T>;
+      std::vector<usint> borders(1, 0);
+      for(usint i = 0; i < parts; i++)
+      {
+        result->insert(result->end(), results[i]->begin(), results[i]->end());
+        delete results[i]; results[i] = 0;
+        borders.push_back(result->size());
+      }
+      for(usint width = 1; width < parts; width *= 2)
+      {
+        for(usint i = 0; i + width < parts; i += 2 * width)
+        {
+          std::inplace_merge(result->begin() + borders[i], result->begin() + borders[i + width],
+                             result->begin() + borders[std::min(i + 2 * width, parts)]);
+        }
+      }
+      this->compactSorted(*result);
+
+      return result;
+    }
+
     template<class T>
     std::vector<T>* allDocuments() const
     {
@@ -287,6 +352,24 @@ class DocArray
       result.push_back(pair_type(item, item));
     }
 
+    // Remove duplicates / merge overlapping runs in a sorted result.
+    inline void compactSorted(std::vector<usint>& result) const
+    {
+      result.resize(std::unique(result.begin(), result.end()) - result.begin());
+    }
+
+    inline void compactSorted(std::vector<pair_type>& result) const
+    {
+      if(result.size() <= 1) { return; }
+      std::vector<pair_type>::iterator prev = result.begin();
+      for(std::vector<pair_type>::iterator curr = prev + 1; curr != result.end(); ++curr)
+      {
+        if(prev->second + 1 >= curr->first) { prev->second = std::max(curr->second, prev->second); }
+        else { ++prev; *prev = *curr; }
+      }
+      result.resize((prev - result.begin()) + 1);
+    }
+
 //--------------------------------------------------------------------------
 
     inline pair_type parentOf(usint tree_node, SuccinctVector::Iterator& iter) const
@@ -0,0 +1,230 @@
+#include <algorithm>
+#include <iostream>
+#include <queue>
+
+#include "doccounts.h"
+#include "misc/utils.h"
+
+#ifdef MULTITHREAD_SUPPORT
+#include <omp.h>
+#endif
+
+
+namespace CSA
+{
+
+
+DocCounts::DocCounts(const RLCSA& _rlcsa, usint threads) :
+  rlcsa(_rlcsa),
+  ok(false)
+{
+  if(!(this->rlcsa.isOk()) || !(this->rlcsa.supportsLocate()))
+  {
+    std::cerr << "DocCounts: Error: The index does not support locate!" << std::endl;
+    return;
+  }
+
+  // Build the document array.
+  usint n = this->getSize();
+  usint* documents = new usint[n];
+  usint chunk = std::max((usint)MEGABYTE, n / (4 * std::max(threads, (usint)1)));
+  usint chunks = (n + chunk - 1) / chunk;
+  #ifdef MULTITHREAD_SUPPORT
+  omp_set_num_threads(threads);
+  #endif
+  #pragma omp parallel for schedule(dynamic, 1)
+  for(usint i = 0; i < chunks; i++)
+  {
+    pair_type range(i * chunk, std::min((i + 1) * chunk, n) - 1);
+    this->rlcsa.locate(range, documents + range.first);
+    this->rlcsa.getSequenceForPosition(documents + range.first, length(range));
+  }
+
+  // Build the wavelet matrix. A single document needs no levels.
+  usint bits = (this->getNumberOfDocuments() > 1 ? length(this->getNumberOfDocuments() - 1) : 0);
+  usint* next = new usint[n];
+  for(usint level = 0; level < bits; level++)
+  {
+    usint bit = bits - 1 - level, level_zeros = 0;
+    SuccinctVector::Encoder encoder(BLOCK_SIZE, nextMultipleOf(BLOCK_SIZE, BITS_TO_BYTES(n)));
+    for(usint i = 0; i < n; i++)
+    {
+      if(GET(documents[i] >> bit, 1)) { encoder.setBit(i); }
+      else { next[level_zeros] = documents[i]; level_zeros++; }
+    }
+    for(usint i = 0, j = level_zeros; i < n; i++)
+    {
+      if(GET(documents[i] >> bit, 1)) { next[j] = documents[i]; j++; }
+    }
+    this->levels.push_back(new SuccinctVector(encoder, n));
+    this->zeros.push_back(level_zeros);
+    std::swap(documents, next);
+  }
+  delete[] documents; documents = 0;
+  delete[] next; next = 0;
+
+  this->ok = true;
+}
+
+DocCounts::DocCounts(const RLCSA& _rlcsa, const std::string& base_name) :
+  rlcsa(_rlcsa),
+  ok(false)
+{
+  std::string input_name = base_name + DOC_COUNTS_EXTENSION;
+  std::ifstream input(input_name.c_str(), std::ios_base::binary);
+  if(!input)
+  {
+    std::cerr << "DocCounts: Error opening input file " << input_name << "!" << std::endl;
+    return;
+  }
+
+  usint bits = 0;
+  input.read((char*)&bits, sizeof(bits));
+  for(usint level = 0; level < bits; level++)
+  {
+    SuccinctVector* vector = new SuccinctVector(input);
+    this->levels.push_back(vector);
+    this->zeros.push_back(vector->getSize() - vector->getNumberOfItems());
+  }
+  input.close();
+
+  if(bits != (this->getNumberOfDocuments() > 1 ? length(this->getNumberOfDocuments() - 1) : 0) ||
+     (bits > 0 && this->levels[0]->getSize() != this->getSize()))
+  {
+    std::cerr << "DocCounts: Error: The structure does not match the index!" << std::endl;
+    return;
+  }
+  this->ok = true;
+}
+
+DocCounts::~DocCounts()
+{
+  for(usint level = 0; level < this->levels.size(); level++)
+  {
+    delete this->levels[level]; this->levels[level] = 0;
+  }
+}
+
+void
+DocCounts::writeTo(const std::string& base_name) const
+{
+  if(!(this->isOk())) { return; }
+
+  std::string output_name = base_name + DOC_COUNTS_EXTENSION;
+  std::ofstream output(output_name.c_str(), std::ios_base::binary);
+  if(!output)
+  {
+    std::cerr << "DocCounts: Error creating output file " << output_name << "!" << std::endl;
+    return;
+  }
+
+  usint bits = this->levels.size();
+  output.write((char*)&bits, sizeof(bits));
+  for(usint level = 0; level < bits; level++) { this->levels[level]->writeTo(output); }
+  output.close();
+}
+
+usint
+DocCounts::reportSize(bool print) const
+{
+  usint bytes = sizeof(*this) + this->zeros.size() * sizeof(usint);
+  for(usint level = 0; level < this->levels.size(); level++)
+  {
+    bytes += this->levels[level]->reportSize();
+  }
+
+  if(print)
+  {
+    std::cout << "Document counts: " << (bytes / (double)MEGABYTE) << " MB (" << this->levels.size() << " levels)" << std::endl;
+    std::cout << std::endl;
+  }
+
+  return bytes;
+}
+
+//--------------------------------------------------------------------------
+
+struct DocCountNode
+{
+  usint     level, value;
+  pair_type range;
+
+  DocCountNode(usint _level, usint _value, pair_type _range) :
+    level(_level), value(_value), range(_range)
+  {
+  }
+
+  // Longer ranges come first.
+  inline bool operator< (const DocCountNode& another) const
+  {
+    return (length(this->range) < length(another.range));
+  }
+};
+
+std::vector<pair_type>*
+DocCounts::topK(const std::string& pattern, usint k) const
+{
+  return this->topK(this->rlcsa.count(pattern), k);
+}
+
+std::vector<pair_type>*
+DocCounts::topK(pair_type range, usint k) const
+{
+  std::vector<pair_type>* result = new std::vector<pair_type>;
+  if(!(this->isOk()) || isEmpty(range) || range.second >= this->getSize() || k == 0) { return result; }
+
+  std::priority_queue<DocCountNode> heap;
+  heap.push(DocCountNode(0, 0, range));
+  while(!(heap.empty()) && result->size() < k)
+  {
+    DocCountNode node = heap.top(); heap.pop();
+    if(node.level >= this->levels.size())
+    {
+      result->push_back(pair_type(node.value, length(node.range)));
+      continue;
+    }
+    for(usint bit = 0; bit < 2; bit++)
+    {
+      pair_type next = this->child(node.level, node.range, bit);
+      if(!isEmpty(next)) { heap.push(DocCountNode(node.level + 1, 2 * node.value + bit, next)); }
+    }
+  }
+
+  return result;
+}
+
+usint
+DocCounts::count(pair_type range, usint document) const
+{
+  if(!(this->isOk()) || isEmpty(range) || range.second >= this->getSize()) { return 0; }
+  if(document >= this->getNumberOfDocuments()) { return 0; }
+
+  for(usint level = 0; level < this->levels.size() && !isEmpty(range); level++)
+  {
+    usint bit = GET(document >> (this->levels.size() - 1 - level), 1);
+    range = this->child(level, range, bit);
+  }
+
+  return (isEmpty(range) ? 0 : length(range));
+}
+
+pair_type
+DocCounts::child(usint level, pair_type range, usint bit) const
+{
+  SuccinctVector::Iterator iter(*(this->levels[level]));
+  usint ones_before = (range.first > 0 ? iter.rank(range.first - 1) : 0);
+  usint ones = iter.rank(range.second) - ones_before;
+  if(bit == 0)
+  {
+    if(ones == length(range)) { return EMPTY_PAIR; }
+    usint zeros_before = range.first - ones_before;
+    return pair_type(zeros_before, zeros_before + (length(range) - ones) - 1);
+  }
+  if(ones == 0) { return EMPTY_PAIR; }
+  usint start = this->zeros[level] + ones_before;
+  return pair_type(start, start + ones - 1);
+}
+
+//--------------------------------------------------------------------------
+
+} // namespace CSA
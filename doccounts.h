@@ -0,0 +1,80 @@
+#ifndef DOCCOUNTS_H
+#define DOCCOUNTS_H
+
+#include <fstream>
+#include <vector>
+
+#include "rlcsa.h"
+#include "bits/succinctvector.h"
+
+
+namespace CSA
+{
+
+
+const std::string DOC_COUNTS_EXTENSION = ".rlcsa.doc_counts";
+
+
+/*
+  Document counting and top-k document retrieval using a wavelet matrix over the
+  document array DA[i] = getSequenceForPosition(SA[i]).
+
+  topK() is the greedy method of Culpepper, Navarro, Puglisi, and Turpin (Top-k ranked
+  document search in general text databases, ESA 2010): the nodes of the wavelet matrix
+  are expanded in decreasing order of range length, so the first k leaves reached are the
+  k most frequent documents. No occurrence is located.
+
+  The structure takes n log d bits plus rank overhead, where d is the number of documents.
+*/
+
+class DocCounts
+{
+  public:
+    const static usint BLOCK_SIZE = 32;
+
+    // Builds the structure by locating every suffix. The index must support locate.
+    DocCounts(const RLCSA& _rlcsa, usint threads);
+    DocCounts(const RLCSA& _rlcsa, const std::string& base_name);
+    ~DocCounts();
+
+    void writeTo(const std::string& base_name) const;
+    usint reportSize(bool print = false) const;
+
+    // Returns (document, occurrences) for the k documents with the most occurrences in
+    // decreasing order of occurrences. The order of documents with equal counts is
+    // unspecified. User must free the returned vector.
+    std::vector<pair_type>* topK(const std::string& pattern, usint k) const;
+    std::vector<pair_type>* topK(pair_type range, usint k) const;
+
+    // Returns the number of occurrences in the given document.
+    usint count(pair_type range, usint document) const;
+
+    inline bool isOk() const { return this->ok; }
+    inline usint getSize() const { return this->rlcsa.getSize(); }
+    inline usint getNumberOfDocuments() const { return this->rlcsa.getNumberOfSequences(); }
+    inline usint getNumberOfLevels() const { return this->levels.size(); }
+
+  private:
+    const RLCSA& rlcsa;
+
+    // Level l contains bit (levels - 1 - l) of the documents. At the next level, the
+    // positions with 0-bits come before the positions with 1-bits.
+    std::vector<SuccinctVector*> levels;
+    std::vector<usint>           zeros;
+
+    bool ok;
+
+    // Maps range to the child with the given bit at the given level.
+    pair_type child(usint level, pair_type range, usint bit) const;
+
+    // These are not allowed.
+    DocCounts();
+    DocCounts(const DocCounts&);
+    DocCounts& operator = (const DocCounts&);
+};
+
+
+} // namespace CSA
+
+
+#endif // DOCCOUNTS_H
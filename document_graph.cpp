@@ -10,6 +10,7 @@
 
 #include "rlcsa.h"
 #include "docarray.h"
+#include "saextractor.h"
 
 using namespace CSA;
 
@@ -20,6 +21,7 @@ using namespace CSA;
 
 
 int testDocarray(const std::string& base_name);
+void addSuffix(std::stack<STNode*>& nodestack, STNode*& prev, STNode*& root, usint i, usint lcp, usint block_size);
 int buildIndex(const std::string& base_name, const std::string& prefix);
 
 
@@ -32,6 +34,8 @@ main(int argc, char** argv)
     std::cout << "Usage:" << std::endl;
     std::cout << "document_graph basename block_size storing_factor" << std::endl;
     std::cout << "  to build the document graph and sparse suffix tree" << std::endl;
+    std::cout << "document_graph basename block_size storing_factor -r" << std::endl;
+    std::cout << "  to compress the grammar in-process using Re-Pair and build the index without the graph" << std::endl;
     std::cout << "document_graph basename prefix" << std::endl;
     std::cout << "  to compress the grammar and build the index" << std::endl;
     std::cout << "document_graph basename" << std::endl;
@@ -63,6 +67,8 @@ main(int argc, char** argv)
   std::cout << "Block size: " << block_size << std::endl;
   usint storing_factor = atoi(argv[3]);
   std::cout << "Storing factor: " << storing_factor << std::endl;
+  bool in_process = (argc > 4 && std::string(argv[4]) == "-r");
+  if(in_process) { std::cout << "Building the grammar in-process" << std::endl; }
   std::cout << std::endl;
 
   RLCSA rlcsa(argv[1]);
@@ -78,117 +84,78 @@ main(int argc, char** argv)
 
   double start = readTimer();
 
-  // Get the suffix array from RLCSA.
+  // Extract the document array and the LCP array in parallel blocks, and build a
+  // truncated suffix tree from the LCP values.
+  // A node with at most block_size suffixes should not have any children.
   usint size = rlcsa.getSize();
   uint docs = rlcsa.getNumberOfSequences();
-  usint* documents = new usint[size];
-  #pragma omp parallel for schedule(static)
-  for(usint i = 0; i < size; i += MEGABYTE)
-  {
-    rlcsa.locate(pair_type(i, std::min(i + MEGABYTE, size - 1)), documents + i);
-  }
-  double locate = readTimer();
-  std::cout << "Locate: " << (locate - start) << " seconds" << std::endl;
-
-  // Get the LCP array.
-  uint* lcp = new uint[size + 1]; lcp[size] = 0;
-/*  #ifdef MULTITHREAD_SUPPORT
-  usint threads = omp_get_max_threads();
-  PLCPVector* plcpvec = rlcsa.buildPLCP(16, threads);
-  std::cout << "Total: " << plcpvec->getNumberOfItems() << " / " << plcpvec->getSize() << std::endl;
-  PLCPVector::Iterator* iters[threads];
-  for(usint i = 0; i < threads; i++) { iters[i] = new PLCPVector::Iterator(*plcpvec); }
-  #pragma omp parallel for schedule(static, MEGABYTE)
-  for(usint i = 0; i < size; i++)
-  {
-    lcp[i] = iters[omp_get_thread_num()]->select(documents[i]) - 2 * documents[i];
-  }
-  for(usint i = 0; i < threads; i++) { delete iters[i]; iters[i] = 0; }
-  #else*/
   PLCPVector* plcpvec = rlcsa.buildPLCP(16);
-  PLCPVector::Iterator iter(*plcpvec);
-  for(usint i = 0; i < size; i++)
-  {
-    lcp[i] = iter.select(documents[i]) - 2 * documents[i];
-  }
-//  #endif
-  delete plcpvec;
-  double lcparray = readTimer();
-  std::cout << "LCP: " << (lcparray - locate) << " seconds" << std::endl;
-
-  // Convert SA to document array.
-  #pragma omp parallel for schedule(static)
-  for(usint i = 0; i < size; i += MEGABYTE)
-  {
-    rlcsa.getSequenceForPosition(documents + i, std::min(MEGABYTE, size - i));
-  }
-  // Change document array to be 1-based.
-  #pragma omp parallel for schedule(static, MEGABYTE)
-  for(usint i = 0; i < size; i++) { documents[i]++; }
-  double find = readTimer();
-  std::cout << "Documents: " << (find - lcparray) << " seconds" << std::endl;
+  double plcp = readTimer();
+  std::cout << "PLCP: " << (plcp - start) << " seconds" << std::endl;
 
-  // Build a truncated suffix tree.
-  // A node with at most block_size suffixes should not have any children.
+  usint threads = 1;
+  #ifdef MULTITHREAD_SUPPORT
+  threads = omp_get_max_threads();
+  #endif
+  usint* documents = new usint[size];
   std::stack<STNode*> nodestack; nodestack.push(new STNode(0, pair_type(0, 0)));
   STNode* prev = 0; STNode* root = 0;
-  for(usint i = 1; i <= size; i++)
+  SAExtractor extractor(rlcsa, plcpvec, SAExtractor::DEFAULT_BLOCK_SIZE, threads);
+  while(extractor.next())
   {
-    usint left = i - 1;
-    while(lcp[i] < nodestack.top()->string_depth)
+    pair_type range = extractor.getRange();
+    const usint* da = extractor.getDA();
+    const usint* lcp = extractor.getLCP();
+    for(usint i = range.first; i <= range.second; i++)
     {
-      nodestack.top()->range.second = i - 1;
-      prev = nodestack.top(); nodestack.pop();
-      if(length(prev->range) <= block_size) { prev->deleteChildren(); }
-      root = prev;  // Last processed node.
-      left = prev->range.first;
-      if(lcp[i] <= nodestack.top()->string_depth) { nodestack.top()->addChild(prev); prev = 0; }
-    }
-    if(lcp[i] > nodestack.top()->string_depth)
-    {
-      STNode* curr = new STNode(lcp[i], pair_type(left, left));
-      if(prev != 0) { curr->addChild(prev); prev = 0; }
-      nodestack.push(curr);
+      documents[i] = da[i - range.first] + 1; // The document array is 1-based.
+      if(i > 0) { addSuffix(nodestack, prev, root, i, lcp[i - range.first], block_size); }
     }
   }
+  addSuffix(nodestack, prev, root, size, 0, block_size);
+  delete plcpvec; plcpvec = 0;
   while(root->parent != 0) { root = root->parent; }  // Find the actual root.
   root->range.second = size - 1; root->containsAllDocuments();
-  delete[] lcp; lcp = 0;
   uint st_nodes = 0, leaf_nodes = 0;
   root->addLeaves();
   root->verifyTree();
   root->determineSize(st_nodes, leaf_nodes);
   double st = readTimer();
-  std::cout << "Suffix tree: " << (st - find) << " seconds" << std::endl;
+  std::cout << "Suffix tree: " << (st - plcp) << " seconds" << std::endl;
   std::cout << "Total " << size << " positions, " << docs << " documents" << std::endl;
   std::cout << "Truncated suffix tree has " << st_nodes << " nodes" << std::endl;
   std::cout << std::endl;
 
 
-  // Start processing.
+  // Start processing. The graph is only written for an external grammar compressor.
   uint tree_leaves = 0, tree_nodes = leaf_nodes, graph_nodes = 0, edges = 0;
-  std::string graph_name = base_name + ".graph";
-  std::ofstream output(graph_name.c_str(), std::ios_base::binary);
-  if(!output)
-  {
-    std::cerr << "Error: Cannot open output file " << graph_name << "!" << std::endl;
-    delete[] documents;
-    return 3;
-  }
-  std::string singleton_name = base_name + ".singletons";
-  std::ofstream singletons(singleton_name.c_str(), std::ios_base::binary);
-  if(!singletons)
+  std::ofstream output, singletons;
+  if(!in_process)
   {
-    std::cerr << "Error: Cannot open output file " << singleton_name << "!" << std::endl;
-    delete[] documents;
-    output.close();
-    return 3;
+    std::string graph_name = base_name + ".graph";
+    output.open(graph_name.c_str(), std::ios_base::binary);
+    if(!output)
+    {
+      std::cerr << "Error: Cannot open output file " << graph_name << "!" << std::endl;
+      delete[] documents;
+      return 3;
+    }
+    std::string singleton_name = base_name + ".singletons";
+    singletons.open(singleton_name.c_str(), std::ios_base::binary);
+    if(!singletons)
+    {
+      std::cerr << "Error: Cannot open output file " << singleton_name << "!" << std::endl;
+      delete[] documents;
+      output.close();
+      return 3;
+    }
+    output.write((char*)&tree_nodes, sizeof(tree_nodes)); // Placeholder for nodes/subsets.
+    output.write((char*)&edges, sizeof(edges)); // Placeholder for edges.
   }
-  output.write((char*)&tree_nodes, sizeof(tree_nodes)); // Placeholder for nodes/subsets.
-  output.write((char*)&edges, sizeof(edges)); // Placeholder for edges.
 
   // For each suffix tree node, produce the corresponding subset if necessary.
   double sets = readTimer();
+  std::vector<std::pair<usint, std::vector<usint> > > stored_sets;
   while(!nodestack.empty()) { nodestack.pop(); }
   for(prev = root; prev != 0; prev = prev->child) { nodestack.push(prev); }
   while(nodestack.top() != root)
@@ -212,19 +179,30 @@ main(int argc, char** argv)
       else                 { curr->id = tree_nodes; tree_nodes++; curr_node -= tree_nodes; }
       if(!(curr->contains_all))
       {
+        if(in_process)
+        {
+          stored_sets.push_back(std::make_pair((usint)(curr->id), std::vector<usint>()));
+          for(std::vector<uint>::iterator iter = curr->docs->begin(); iter != curr->docs->end(); ++iter)
+          {
+            stored_sets.rbegin()->second.push_back(*iter - 1);
+          }
+        }
         // Store singletons in a separate file. The presence of singletons greatly slows down the
         // search for bicliques.
         if(curr->docs->size() == 1)
         {
-          singletons << (-curr_node) << ": " << curr->docs->at(0) << std::endl;
+          if(!in_process) { singletons << (-curr_node) << ": " << curr->docs->at(0) << std::endl; }
         }
         else
         {
-          output.write((char*)&curr_node, sizeof(curr_node));
-          for(std::vector<uint>::iterator iter = curr->docs->begin(); iter != curr->docs->end(); ++iter)
+          if(!in_process)
           {
-            uint temp = *iter;
-            output.write((char*)&temp, sizeof(temp));
+            output.write((char*)&curr_node, sizeof(curr_node));
+            for(std::vector<uint>::iterator iter = curr->docs->begin(); iter != curr->docs->end(); ++iter)
+            {
+              uint temp = *iter;
+              output.write((char*)&temp, sizeof(temp));
+            }
           }
           graph_nodes++;
           edges += curr->docs->size();
@@ -243,13 +221,16 @@ main(int argc, char** argv)
   std::cout << std::endl;
 
   // Write the number of nodes & edges.
-  output.seekp(0, std::ios::beg);
-  output.write((char*)&graph_nodes, sizeof(graph_nodes));
-  output.write((char*)&edges, sizeof(edges));
+  if(!in_process)
+  {
+    output.seekp(0, std::ios::beg);
+    output.write((char*)&graph_nodes, sizeof(graph_nodes));
+    output.write((char*)&edges, sizeof(edges));
+    output.close();
+    singletons.close();
+  }
   std::cout << "Graph has " << graph_nodes << " nodes, " << edges << " edges" << std::endl;
   std::cout << std::endl;
-  output.close();
-  singletons.close();
   delete[] documents;
 
   // Write the tree structure.
@@ -258,6 +239,13 @@ main(int argc, char** argv)
   {
     std::cout << "Final tree has " << docarray.getNumberOfNodes() << " nodes, " << tree_leaves << " leaves" << std::endl;
     std::cout << std::endl;
+    if(in_process)
+    {
+      double grammar_start = readTimer();
+      docarray.buildRules(stored_sets, threads, true);
+      std::cout << "Grammar: " << (readTimer() - grammar_start) << " seconds" << std::endl;
+      std::cout << std::endl;
+    }
     docarray.reportSize(true);
     docarray.writeTo(base_name);
   }
@@ -267,6 +255,29 @@ main(int argc, char** argv)
 }
 
 
+// Processes the suffix at SA position i, where lcp is LCP[i].
+void
+addSuffix(std::stack<STNode*>& nodestack, STNode*& prev, STNode*& root, usint i, usint lcp, usint block_size)
+{
+  usint left = i - 1;
+  while(lcp < nodestack.top()->string_depth)
+  {
+    nodestack.top()->range.second = i - 1;
+    prev = nodestack.top(); nodestack.pop();
+    if(length(prev->range) <= block_size) { prev->deleteChildren(); }
+    root = prev;  // Last processed node.
+    left = prev->range.first;
+    if(lcp <= nodestack.top()->string_depth) { nodestack.top()->addChild(prev); prev = 0; }
+  }
+  if(lcp > nodestack.top()->string_depth)
+  {
+    STNode* curr = new STNode(lcp, pair_type(left, left));
+    if(prev != 0) { curr->addChild(prev); prev = 0; }
+    nodestack.push(curr);
+  }
+}
+
+
 int
 testDocarray(const std::string& base_name)
 {
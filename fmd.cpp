@@ -2,12 +2,59 @@
 #include <algorithm>
 #include <stdexcept>
 
+#ifdef MULTITHREAD_SUPPORT
+#include <omp.h>
+#endif
+
 namespace CSA
 {
 
 const std::string BASES = "TGCNA";
 const std::string ALPHABETICAL_BASES = "ACGNT";
 
+RangeIndex::RangeIndex(const RangeVector& ranges):
+  items(ranges.getNumberOfItems())
+{
+  // Get the boundaries in sorted order.
+  usint* sorted = new usint[this->items];
+  RangeVector::Iterator iter(ranges);
+  for(usint i = 0; i < this->items; i++)
+  {
+    sorted[i] = (i == 0 ? iter.select(0) : iter.selectNext());
+  }
+
+  // Lay them out in BFS order.
+  this->boundaries = new usint[this->items + 1];
+  this->ranks = new usint[this->items + 1];
+  this->boundaries[0] = 0;
+  this->ranks[0] = this->items;
+  usint next = 0;
+  this->fill(sorted, next, 1);
+
+  delete[] sorted;
+}
+
+RangeIndex::~RangeIndex()
+{
+  delete[] this->boundaries; this->boundaries = 0;
+  delete[] this->ranks; this->ranks = 0;
+}
+
+void
+RangeIndex::fill(const usint* sorted, usint& next, usint k)
+{
+  if(k > this->items) { return; }
+  this->fill(sorted, next, 2 * k);
+  this->boundaries[k] = sorted[next]; this->ranks[k] = next; next++;
+  this->fill(sorted, next, 2 * k + 1);
+}
+
+usint
+RangeIndex::reportSize() const
+{
+  return sizeof(*this) + 2 * (this->items + 1) * sizeof(usint);
+}
+
 FMDPosition::FMDPosition(usint forward_start, usint reverse_start,
   usint end_offset): forward_start(forward_start), reverse_start(reverse_start),
   end_offset(end_offset)
@@ -76,6 +123,23 @@ FMDPosition::ranges(const RangeVector& ranges) const
   return(end_range - start_range + 1);
 }
 
+sint
+FMDPosition::range(const RangeIndex& ranges) const
+{
+  // Both ends of the interval must be in the same range.
+  sint start_range = ranges.rank(forward_start);
+  sint end_range = ranges.rank(forward_start + end_offset);
+  return (start_range == end_range ? start_range : -1);
+}
+
+sint
+FMDPosition::ranges(const RangeIndex& ranges) const
+{
+  // Return the number of ranges we intersect (1s hit plus 1)
+  return ranges.rank(forward_start + end_offset) -
+    ranges.rank(forward_start) + 1;
+}
+
 std::ostream& operator<< (std::ostream& o, FMDPosition const& position)
 {
   // Report both the ranges that we represent.
@@ -115,6 +179,37 @@ operator<< (std::ostream& o, Mapping const& mapping)
   return o;
 }
 
+Occurrence::Occurrence(): text(0), offset(0), is_reverse(false)
+{
+}
+
+Occurrence::Occurrence(usint text, usint offset, bool is_reverse): text(text),
+  offset(offset), is_reverse(is_reverse)
+{
+}
+
+bool
+Occurrence::operator==(const Occurrence& other) const
+{
+  return text == other.text && offset == other.offset &&
+    is_reverse == other.is_reverse;
+}
+
+bool
+Occurrence::operator<(const Occurrence& other) const
+{
+  if(text != other.text) { return text < other.text; }
+  if(offset != other.offset) { return offset < other.offset; }
+  return !is_reverse && other.is_reverse;
+}
+
+std::ostream&
+operator<< (std::ostream& o, Occurrence const& occurrence)
+{
+  return o << "Text " << occurrence.text << " offset " << occurrence.offset <<
+    " strand " << (occurrence.is_reverse ? "-" : "+");
+}
+
 // Stuff for FMDIterators that traverse the suffix tree.
 
 FMDIterator::FMDIterator(const FMD& parent, usint depth, bool beEnd,
@@ -437,9 +532,215 @@ std::pair<FMDPosition, usint> FMDIterator::pop()
   return toReturn;
 }
 
+// Stuff for k-mer lookup tables.
+
+KmerTable::KmerTable(const FMD& parent, usint _k): k(_k), forward_starts(0),
+  reverse_starts(0), lengths(0), ok(false)
+{
+  if(this->k == 0 || this->k > MAX_K)
+  {
+    std::cerr << "KmerTable: Invalid k-mer length " << this->k << "!" <<
+      std::endl;
+    return;
+  }
+
+  // One entry per k-mer over {A, C, G, T}, each field wide enough to hold any
+  // BWT position.
+  usint entries = (usint)1 << (2 * this->k);
+  usint item_bits = length(parent.getSize() + parent.getNumberOfSequences());
+  WriteBuffer forward(entries, item_bits);
+  WriteBuffer reverse(entries, item_bits);
+  WriteBuffer lens(entries, item_bits);
+
+  for(FMD::iterator iter = parent.begin(this->k); iter != parent.end(this->k);
+    ++iter)
+  {
+    std::pair<std::string, FMDPosition> kmer = *iter;
+
+    // Pack the k-mer, skipping the ones containing N.
+    usint key = 0, code = 0;
+    for(usint i = 0; i < this->k && code < 4; i++)
+    {
+      code = encode(kmer.first[i]);
+      key = (key << 2) | code;
+    }
+    if(code >= 4) { continue; }
+
+    // The iterator reports SA coordinates, but searches work in BWT space.
+    parent.convertToBWTIndex(kmer.second.forward_start);
+    parent.convertToBWTIndex(kmer.second.reverse_start);
+
+    forward.goToItem(key); forward.writeItem(kmer.second.forward_start);
+    reverse.goToItem(key); reverse.writeItem(kmer.second.reverse_start);
+    lens.goToItem(key); lens.writeItem(kmer.second.getLength());
+  }
+
+  this->forward_starts = forward.getReadBuffer();
+  this->reverse_starts = reverse.getReadBuffer();
+  this->lengths = lens.getReadBuffer();
+  this->ok = true;
+}
+
+KmerTable::KmerTable(const std::string& base_name): k(0), forward_starts(0),
+  reverse_starts(0), lengths(0), ok(false)
+{
+  std::string kmer_name = base_name + KMER_TABLE_EXTENSION;
+  std::ifstream kmer_file(kmer_name.c_str(), std::ios_base::binary);
+  if(!kmer_file)
+  {
+    std::cerr << "KmerTable: Error opening k-mer table file!" << std::endl;
+    return;
+  }
+
+  usint item_bits = 0;
+  kmer_file.read((char*)&(this->k), sizeof(this->k));
+  kmer_file.read((char*)&item_bits, sizeof(item_bits));
+  if(!kmer_file || this->k == 0 || this->k > MAX_K || item_bits == 0)
+  {
+    std::cerr << "KmerTable: Invalid k-mer table header!" << std::endl;
+    return;
+  }
+
+  usint entries = (usint)1 << (2 * this->k);
+  this->forward_starts = new ReadBuffer(kmer_file, entries, item_bits);
+  this->reverse_starts = new ReadBuffer(kmer_file, entries, item_bits);
+  this->lengths = new ReadBuffer(kmer_file, entries, item_bits);
+  kmer_file.close();
+
+  this->ok = true;
+}
+
+KmerTable::~KmerTable()
+{
+  delete this->forward_starts; this->forward_starts = 0;
+  delete this->reverse_starts; this->reverse_starts = 0;
+  delete this->lengths; this->lengths = 0;
+}
+
+void
+KmerTable::writeTo(const std::string& base_name) const
+{
+  if(!this->ok) { return; }
+
+  std::string kmer_name = base_name + KMER_TABLE_EXTENSION;
+  std::ofstream kmer_file(kmer_name.c_str(), std::ios_base::binary);
+  if(!kmer_file)
+  {
+    std::cerr << "KmerTable: Error creating k-mer table file!" << std::endl;
+    return;
+  }
+
+  usint item_bits = this->lengths->getItemSize();
+  kmer_file.write((char*)&(this->k), sizeof(this->k));
+  kmer_file.write((char*)&item_bits, sizeof(item_bits));
+  this->forward_starts->writeBuffer(kmer_file);
+  this->reverse_starts->writeBuffer(kmer_file);
+  this->lengths->writeBuffer(kmer_file);
+  kmer_file.close();
+}
+
+bool
+KmerTable::lookup(const std::string& pattern, usint start,
+  FMDPosition& result) const
+{
+  if(!this->ok || start + this->k > pattern.length()) { return false; }
+
+  usint key = 0;
+  for(usint i = start; i < start + this->k; i++)
+  {
+    usint code = encode(pattern[i]);
+    if(code >= 4) { return false; }
+    key = (key << 2) | code;
+  }
+
+  usint len = this->lengths->readItemConst(key);
+  if(len == 0)
+  {
+    result = EMPTY_FMD_POSITION;
+  }
+  else
+  {
+    result = FMDPosition(this->forward_starts->readItemConst(key),
+      this->reverse_starts->readItemConst(key), len - 1);
+  }
+  return true;
+}
+
+usint
+KmerTable::reportSize() const
+{
+  usint bytes = sizeof(*this);
+  if(this->ok)
+  {
+    bytes += this->forward_starts->reportSize();
+    bytes += this->reverse_starts->reportSize();
+    bytes += this->lengths->reportSize();
+  }
+  return bytes;
+}
+
 FMD::FMD(const std::string& base_name, bool print): 
-  RLCSA(base_name, print)
+  RLCSA(base_name, print), kmers(0)
+{
+  if(!this->isOk()) { return; }
+
+  // The k-mer table is optional, so only try to load it if it exists.
+  std::string kmer_name = base_name + KMER_TABLE_EXTENSION;
+  std::ifstream kmer_file(kmer_name.c_str(), std::ios_base::binary);
+  if(!kmer_file) { return; }
+  kmer_file.close();
+
+  this->kmers = new KmerTable(base_name);
+  if(!this->kmers->isOk())
+  {
+    delete this->kmers; this->kmers = 0;
+    return;
+  }
+  if(print)
+  {
+    std::cout << "K-mer table: k = " << this->kmers->getK() << ", " <<
+      (this->kmers->reportSize() / (double)MEGABYTE) << " MB" << std::endl;
+    std::cout << std::endl;
+  }
+}
+
+FMD::~FMD()
+{
+  delete this->kmers; this->kmers = 0;
+}
+
+void
+FMD::setKmerTable(KmerTable* table)
+{
+  if(table == this->kmers) { return; }
+  delete this->kmers;
+  this->kmers = table;
+}
+
+pair_type
+FMD::count(const std::string& pattern) const
 {
+  FMDPosition kmer_position;
+  if(this->kmers == 0 || pattern.length() < this->kmers->getK() ||
+    !this->kmers->lookup(pattern, pattern.length() - this->kmers->getK(),
+    kmer_position))
+  {
+    // No table or no usable k-mer at the end of the pattern.
+    return RLCSA::count(pattern);
+  }
+  if(kmer_position.isEmpty()) { return EMPTY_PAIR; }
+
+  // Continue the backward search from the k-mer range.
+  pair_type index_range(kmer_position.forward_start,
+    kmer_position.forward_start + kmer_position.end_offset);
+  for(sint i = pattern.length() - this->kmers->getK() - 1; i >= 0; i--)
+  {
+    index_range = this->LF(index_range, (uchar)pattern[i]);
+    if(isEmpty(index_range)) { return EMPTY_PAIR; }
+  }
+
+  this->convertToSARange(index_range);
+  return index_range;
 }
 
 FMDPosition
@@ -667,46 +968,69 @@ FMD::fmdCount(const std::string& pattern, bool backward) const
 
   // Keep an FMDPosition to store our intermediate result in.
   FMDPosition index_position;
+  
+  // How long a k-mer can we start from with the lookup table?
+  usint k = (this->kmers == 0 ? 0 : this->kmers->getK());
+  if(k > pattern.length()) { k = 0; }
 
   if(backward)
   {
-    // Start at the end of the pattern and work towards the front
+    // Start at the end of the pattern and work towards the front. If the last
+    // k characters are in the k-mer table, start from them instead.
     
-    std::string::const_reverse_iterator iter = pattern.rbegin();
-    index_position = this->getCharPosition((uchar)*iter);
+    sint i = pattern.length() - 1;
+    if(k > 0 && this->kmers->lookup(pattern, pattern.length() - k,
+      index_position))
+    {
+      i -= k;
+    }
+    else
+    {
+      index_position = this->getCharPosition((uchar)pattern[i]);
+      i--;
+    }
     if(index_position.isEmpty()) { return index_position; }
 
     DEBUG(std::cout << "Starting with " << index_position << std::endl;)
 
-    for(++iter; iter != pattern.rend(); ++iter)
+    for(; i >= 0; i--)
     {
       // Backwards extend with subsequent characters.
-      index_position = this->extend(index_position, *iter, true);
-      DEBUG(std::cout << "Now at " << index_position << " after " << *iter <<
-        std::endl;)
+      index_position = this->extend(index_position, pattern[i], true);
+      DEBUG(std::cout << "Now at " << index_position << " after " <<
+        pattern[i] << std::endl;)
       // Test out retracting
-      //DEBUG(this->retract(index_position, *iter, true);)
+      //DEBUG(this->retract(index_position, pattern[i], true);)
       if(index_position.isEmpty()) { return EMPTY_FMD_POSITION; }
     }
   }
   else 
   {
-    // Start at the front of the pattern and work towards the end.
+    // Start at the front of the pattern and work towards the end, again
+    // skipping the first k characters if we can.
     
-    std::string::const_iterator iter = pattern.begin();
-    index_position = this->getCharPosition((uchar)*iter);
+    usint i = 0;
+    if(k > 0 && this->kmers->lookup(pattern, 0, index_position))
+    {
+      i += k;
+    }
+    else
+    {
+      index_position = this->getCharPosition((uchar)pattern[i]);
+      i++;
+    }
     if(index_position.isEmpty()) { return index_position; }
 
     DEBUG(std::cout << "Starting with " << index_position << std::endl;)
 
-    for(++iter; iter != pattern.end(); ++iter)
+    for(; i < pattern.length(); i++)
     {
       // Forwards extend with subsequent characters.
-      index_position = this->extend(index_position, *iter, false);
-      DEBUG(std::cout << "Now at " << index_position << " after " << *iter << 
-        std::endl;)
+      index_position = this->extend(index_position, pattern[i], false);
+      DEBUG(std::cout << "Now at " << index_position << " after " <<
+        pattern[i] << std::endl;)
       // Test out retracting
-      //DEBUG(this->retract(index_position, *iter, false);)
+      //DEBUG(this->retract(index_position, pattern[i], false);)
       if(index_position.isEmpty()) { return EMPTY_FMD_POSITION; }
     }
     
@@ -717,6 +1041,231 @@ FMD::fmdCount(const std::string& pattern, bool backward) const
   return index_position;
 }
 
+struct FMD::SearchScheme
+{
+  // Part j is pattern[borders[j], borders[j + 1] - 1].
+  std::vector<usint> borders;
+  
+  // Part order[i] is matched i-th, after which the cumulative number of errors
+  // must be in [lower[i], upper[i]].
+  std::vector<usint> order, lower, upper;
+  
+  // The search state for the empty pattern, which includes the end markers.
+  FMDPosition root;
+};
+
+std::vector<FMDPosition>
+FMD::fmdApproximateCount(const std::string& pattern, usint errors,
+  bool edits) const
+{
+  std::vector<FMDPosition> results;
+  
+  // Pick the parts and the searches. We use the optimal schemes of Kucherov et
+  // al. for 1 and 2 errors, and the pigeonhole scheme (some part must be
+  // matched exactly) for more. Patterns shorter than the number of parts are
+  // searched with plain backtracking.
+  usint parts = (errors == 0 ? 1 : errors + 1);
+  if(pattern.length() < parts) { parts = 1; }
+  std::vector<std::vector<usint> > orders, lowers, uppers;
+  if(parts == 1)
+  {
+    orders.push_back(std::vector<usint>(1, 0));
+    lowers.push_back(std::vector<usint>(1, 0));
+    uppers.push_back(std::vector<usint>(1, errors));
+  }
+  else if(errors <= 2)
+  {
+    static const usint one[2][3][2] =
+    {
+      { { 0, 1 }, { 0, 0 }, { 0, 1 } },
+      { { 1, 0 }, { 0, 1 }, { 0, 1 } }
+    };
+    static const usint two[3][3][3] =
+    {
+      { { 0, 1, 2 }, { 0, 0, 0 }, { 0, 2, 2 } },
+      { { 2, 1, 0 }, { 0, 0, 0 }, { 0, 1, 2 } },
+      { { 1, 0, 2 }, { 0, 1, 1 }, { 0, 1, 2 } }
+    };
+    for(usint i = 0; i < parts; i++)
+    {
+      const usint* order = (errors == 1 ? one[i][0] : two[i][0]);
+      const usint* lower = (errors == 1 ? one[i][1] : two[i][1]);
+      const usint* upper = (errors == 1 ? one[i][2] : two[i][2]);
+      orders.push_back(std::vector<usint>(order, order + parts));
+      lowers.push_back(std::vector<usint>(lower, lower + parts));
+      uppers.push_back(std::vector<usint>(upper, upper + parts));
+    }
+  }
+  else
+  {
+    for(usint i = 0; i < parts; i++)
+    {
+      std::vector<usint> order;
+      for(usint j = i; j < parts; j++) { order.push_back(j); }
+      for(usint j = i; j > 0; j--) { order.push_back(j - 1); }
+      orders.push_back(order);
+      lowers.push_back(std::vector<usint>(parts, 0));
+      std::vector<usint> upper(parts, errors); upper[0] = 0;
+      uppers.push_back(upper);
+    }
+  }
+  
+  SearchScheme scheme;
+  for(usint j = 0; j <= parts; j++)
+  {
+    scheme.borders.push_back((j * pattern.length()) / parts);
+  }
+  scheme.root = FMDPosition(0, 0,
+    this->data_size + this->number_of_sequences - 1);
+  for(usint i = 0; i < orders.size(); i++)
+  {
+    scheme.order = orders[i]; scheme.lower = lowers[i];
+    scheme.upper = uppers[i];
+    usint start = scheme.borders[scheme.order[0]];
+    this->approximateSearch(scheme, pattern, scheme.root, 0, start, start, 0,
+      edits, results);
+  }
+  
+  // Convert to SA space and merge the duplicates, which we get when a match
+  // is found by more than one search. Forward intervals are either disjoint or
+  // nested, so it is enough to drop the ones inside the previous one.
+  for(usint i = 0; i < results.size(); i++)
+  {
+    this->convertToSAPosition(results[i]);
+  }
+  std::vector<std::pair<pair_type, usint> > order;
+  for(usint i = 0; i < results.size(); i++)
+  {
+    // Sort by start, longest first.
+    order.push_back(std::make_pair(pair_type(results[i].forward_start,
+      ~(usint)(results[i].end_offset)), i));
+  }
+  std::sort(order.begin(), order.end());
+  std::vector<FMDPosition> merged;
+  for(usint i = 0; i < order.size(); i++)
+  {
+    const FMDPosition& next = results[order[i].second];
+    if(!merged.empty() && next.forward_start + next.end_offset <=
+      merged.back().forward_start + merged.back().end_offset) { continue; }
+    merged.push_back(next);
+  }
+  
+  return merged;
+}
+
+void
+FMD::approximateSearch(const SearchScheme& scheme, const std::string& pattern,
+  const FMDPosition& position, usint step, usint left, usint right,
+  usint errors, bool edits, std::vector<FMDPosition>& results) const
+{
+  // Which part are we in? It is done when the matched block covers it.
+  usint part = scheme.order[step];
+  if(left <= scheme.borders[part] && right >= scheme.borders[part + 1])
+  {
+    // The part is done. Check the lower bound and move on.
+    if(errors < scheme.lower[step]) { return; }
+    if(step + 1 < scheme.order.size())
+    {
+      this->approximateSearch(scheme, pattern, position, step + 1, left, right,
+        errors, edits, results);
+    }
+    else if(!(position == scheme.root))
+    {
+      results.push_back(position);
+    }
+    return;
+  }
+  
+  // The first part is matched forward, and the later ones grow the matched
+  // block towards themselves.
+  bool forward = (left <= scheme.borders[part]);
+  usint target = (forward ? pattern[right] : pattern[left - 1]);
+  usint next_left = (forward ? left : left - 1);
+  usint next_right = (forward ? right + 1 : right);
+  bool can_err = (errors < scheme.upper[step]);
+  
+  for(usint base = 0; base < NUM_BASES; base++)
+  {
+    usint c = ALPHABETICAL_BASES[base];
+    FMDPosition next = (position == scheme.root ? this->getCharPosition(c) :
+      this->extend(position, c, !forward));
+    if(next.isEmpty()) { continue; }
+    
+    // Match or mismatch.
+    if(c == target)
+    {
+      this->approximateSearch(scheme, pattern, next, step, next_left,
+        next_right, errors, edits, results);
+    }
+    else if(can_err)
+    {
+      this->approximateSearch(scheme, pattern, next, step, next_left,
+        next_right, errors + 1, edits, results);
+    }
+    
+    // Deletion: the text has an extra character.
+    if(edits && can_err)
+    {
+      this->approximateSearch(scheme, pattern, next, step, left, right,
+        errors + 1, edits, results);
+    }
+  }
+  
+  // Insertion: the pattern has an extra character.
+  if(edits && can_err)
+  {
+    this->approximateSearch(scheme, pattern, position, step, next_left,
+      next_right, errors + 1, edits, results);
+  }
+}
+
+std::vector<Occurrence>
+FMD::locateFolded(const FMDPosition& position, usint pattern_length) const
+{
+  if(this->number_of_sequences % 2 != 0)
+  {
+    throw std::runtime_error("Texts are not paired with reverse complements");
+  }
+
+  std::vector<Occurrence> occurrences;
+  if(position.isEmpty()) { return occurrences; }
+
+  pair_type range(position.forward_start,
+    position.forward_start + position.end_offset);
+  usint* positions = this->locate(range);
+  if(positions == 0) { return occurrences; }
+
+  occurrences.reserve(length(range));
+  for(usint i = 0; i < length(range); i++)
+  {
+    pair_type location = this->getRelativePosition(positions[i]);
+    if(location.first % 2 == 0)
+    {
+      // Forward strand occurrence.
+      occurrences.push_back(Occurrence(location.first, location.second,
+        false));
+    }
+    else
+    {
+      // The occurrence in the reverse complement text is the reverse
+      // complement of an occurrence in the forward text. Flip the coordinates.
+      usint text_length = length(this->getSequenceRange(location.first));
+      occurrences.push_back(Occurrence(location.first - 1,
+        text_length - location.second - pattern_length, true));
+    }
+  }
+  delete[] positions; positions = 0;
+
+  std::sort(occurrences.begin(), occurrences.end());
+  return occurrences;
+}
+
+std::vector<Occurrence>
+FMD::locateFolded(const std::string& pattern) const
+{
+  return this->locateFolded(this->fmdCount(pattern), pattern.length());
+}
+
 std::pair<pair_type, usint>
 FMD::countUntilUnique(const std::string& pattern, usint index) const
 {
@@ -780,22 +1329,38 @@ FMD::mapPosition(const std::string& pattern, usint index) const
   MapAttemptResult result;
   
   // Do a backward search.
-  // Start at the given index, and get the starting range for that character.
   result.is_mapped = false;
-  result.position = this->getCharPosition(pattern[index]);
-  result.characters = 1;
-  if(result.position.isEmpty())
+  
+  // If the k-mer ending at the given index is in the k-mer table and still
+  // matches multiple places, every shorter context does too, so we can start
+  // from the k-mer without changing the answer.
+  usint k = (this->kmers == 0 ? 0 : this->kmers->getK());
+  if(k > 1 && index + 1 >= k &&
+    this->kmers->lookup(pattern, index + 1 - k, result.position) &&
+    result.position.getLength() > 1)
   {
-    // This character isn't even in it. Just return the result with an empty
-    // FMDPosition; the next character we want to map is going to have to deal
-    // with having some never-before-seen character right upstream of it.
-    return result;
+    result.characters = k;
+    index -= k - 1;
   }
-  else if(result.position.getLength() == 1)
+  else
   {
-    // We've already mapped.
-    result.is_mapped = true;
-    return result;
+    // Start at the given index, and get the starting range for that character.
+    result.position = this->getCharPosition(pattern[index]);
+    result.characters = 1;
+    if(result.position.isEmpty())
+    {
+      // This character isn't even in it. Just return the result with an empty
+      // FMDPosition; the next character we want to map is going to have to
+      // deal with having some never-before-seen character right upstream of
+      // it.
+      return result;
+    }
+    else if(result.position.getLength() == 1)
+    {
+      // We've already mapped.
+      result.is_mapped = true;
+      return result;
+    }
   }
 
   if(index == 0) {
@@ -859,6 +1424,21 @@ FMD::mapPosition(const std::string& pattern, usint index) const
 MapAttemptResult
 FMD::mapPosition(const RangeVector& ranges, const std::string& pattern, 
   usint index) const
+{
+  return this->mapPositionToRanges(ranges, pattern, index);
+}
+
+MapAttemptResult
+FMD::mapPosition(const RangeIndex& ranges, const std::string& pattern,
+  usint index) const
+{
+  return this->mapPositionToRanges(ranges, pattern, index);
+}
+
+template<class Ranges>
+MapAttemptResult
+FMD::mapPositionToRanges(const Ranges& ranges, const std::string& pattern,
+  usint index) const
 {
   // We're going to right-map so ranges match up with the things we can map to
   // (downstream contexts)
@@ -869,22 +1449,37 @@ FMD::mapPosition(const RangeVector& ranges, const std::string& pattern,
   MapAttemptResult result;
   
   // Do a forward search.
-  // Start at the given index, and get the starting range for that character.
   result.is_mapped = false;
-  result.position = this->getCharPosition(pattern[index]);
-  result.characters = 1;
-  if(result.position.isEmpty())
+  
+  // If the k-mer starting at the given index is in the k-mer table and still
+  // spans multiple ranges, so does every shorter context, and we can start
+  // from the k-mer.
+  usint k = (this->kmers == 0 ? 0 : this->kmers->getK());
+  if(k > 1 && this->kmers->lookup(pattern, index, result.position) &&
+    !result.position.isEmpty() && result.position.range(ranges) == -1)
   {
-    // This character isn't even in it. Just return the result with an empty
-    // FMDPosition; the next character we want to map is going to have to deal
-    // with having some never-before-seen character right upstream of it.
-    return result;
+    result.characters = k;
+    index += k - 1;
   }
-  else if (result.position.range(ranges) != -1)
+  else
   {
-    // We've already mapped.
-    result.is_mapped = true;
-    return result;
+    // Start at the given index, and get the starting range for that character.
+    result.position = this->getCharPosition(pattern[index]);
+    result.characters = 1;
+    if(result.position.isEmpty())
+    {
+      // This character isn't even in it. Just return the result with an empty
+      // FMDPosition; the next character we want to map is going to have to
+      // deal with having some never-before-seen character right upstream of
+      // it.
+      return result;
+    }
+    else if (result.position.range(ranges) != -1)
+    {
+      // We've already mapped.
+      result.is_mapped = true;
+      return result;
+    }
   }
 
   DEBUG(std::cout << "Starting with " << result.position << std::endl;)
@@ -1110,6 +1705,21 @@ FMD::mapFM(const std::string& query, usint start, sint length) const
 
 std::vector<sint> 
 FMD::map(const RangeVector& ranges, const std::string& query, usint start, 
+  sint length) const
+{
+  return this->mapToRanges(ranges, query, start, length);
+}
+
+std::vector<sint>
+FMD::map(const RangeIndex& ranges, const std::string& query, usint start,
+  sint length) const
+{
+  return this->mapToRanges(ranges, query, start, length);
+}
+
+template<class Ranges>
+std::vector<sint> 
+FMD::mapToRanges(const Ranges& ranges, const std::string& query, usint start, 
   sint length) const {
   
   // RIGHT-map to a range.
@@ -1241,6 +1851,89 @@ FMD::iterator FMD::end(usint depth, bool reportDeadEnds) const
   return FMD::iterator(*this, depth, true, reportDeadEnds);
 }
 
+void
+FMD::enumerate(usint depth, FMDVisitor& visitor, usint threads) const
+{
+  if(depth == 0) { return; }
+
+  // Split the tree by prefixes, using enough of them that dynamic scheduling
+  // can balance the very uneven subtree sizes.
+  usint prefix_length = 1, partitions = NUM_BASES;
+  while(prefix_length < depth && partitions < 16 * threads)
+  {
+    prefix_length++; partitions *= NUM_BASES;
+  }
+
+  // Find the non-empty prefixes breadth-first, in BWT coordinates.
+  std::vector<std::pair<std::string, FMDPosition> > prefixes;
+  for(usint base = 0; base < NUM_BASES; base++)
+  {
+    FMDPosition position = this->getCharPosition(ALPHABETICAL_BASES[base]);
+    if(position.isEmpty()) { continue; }
+    prefixes.push_back(std::make_pair(std::string(1, ALPHABETICAL_BASES[base]),
+      position));
+  }
+  for(usint level = 1; level < prefix_length; level++)
+  {
+    std::vector<std::pair<std::string, FMDPosition> > next;
+    for(usint i = 0; i < prefixes.size(); i++)
+    {
+      for(usint base = 0; base < NUM_BASES; base++)
+      {
+        FMDPosition position = this->extend(prefixes[i].second,
+          ALPHABETICAL_BASES[base], false);
+        if(position.isEmpty()) { continue; }
+        next.push_back(std::make_pair(prefixes[i].first +
+          ALPHABETICAL_BASES[base], position));
+      }
+    }
+    prefixes.swap(next);
+  }
+
+  #ifdef MULTITHREAD_SUPPORT
+  omp_set_num_threads(threads);
+  #endif
+
+  #pragma omp parallel for schedule(dynamic, 1)
+  for(usint i = 0; i < prefixes.size(); i++)
+  {
+    usint thread = 0;
+    #ifdef MULTITHREAD_SUPPORT
+    thread = omp_get_thread_num();
+    #endif
+
+    std::string pattern = prefixes[i].first;
+    pattern.reserve(depth);
+    this->enumerateFrom(prefixes[i].second, pattern, depth, visitor, thread);
+  }
+}
+
+void
+FMD::enumerateFrom(const FMDPosition& position, std::string& pattern,
+  usint depth, FMDVisitor& visitor, usint thread) const
+{
+  if(pattern.length() >= depth)
+  {
+    // Report in SA coordinates, like FMDIterator.
+    FMDPosition sa_position = position;
+    this->convertToSAPosition(sa_position);
+    visitor.visit(pattern, sa_position, thread);
+    return;
+  }
+
+  for(usint base = 0; base < NUM_BASES; base++)
+  {
+    // Append each base in turn, going deeper only into non-empty nodes.
+    FMDPosition extension = this->extend(position, ALPHABETICAL_BASES[base],
+      false);
+    if(extension.isEmpty()) { continue; }
+
+    pattern.push_back(ALPHABETICAL_BASES[base]);
+    this->enumerateFrom(extension, pattern, depth, visitor, thread);
+    pattern.erase(pattern.length() - 1);
+  }
+}
+
 usint FMD::extends = 0;
 usint FMD::restarts = 0;
 
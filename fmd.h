@@ -45,6 +45,64 @@ namespace CSA
   typedef RLEEncoder RangeEncoder;
 #endif
 
+/**
+ * A cache-friendly copy of the 1-bits of a RangeVector, for answering the rank
+ * queries of range membership checks without decoding the compressed vector.
+ * The range start positions are stored in Eytzinger (BFS) order, which makes
+ * the binary search branch-free and lets us prefetch the next levels. Uses
+ * about two words per range, so it is meant for at most a few million ranges.
+ */
+class RangeIndex
+{
+  public:
+    explicit RangeIndex(const RangeVector& ranges);
+    ~RangeIndex();
+    
+    /**
+     * Return the number of range start positions <= value, like
+     * RangeVector::Iterator::rank(value).
+     */
+    inline usint rank(usint value) const
+    {
+      usint k = 1;
+      while(k <= this->items)
+      {
+        __builtin_prefetch(this->boundaries + 16 * k);
+        k = 2 * k + (this->boundaries[k] <= value);
+      }
+      // Undo the right turns taken after the last left turn. That leaves the
+      // first boundary > value, or 0 if there is none.
+      k >>= __builtin_ffsll(~(unsigned long long)k);
+      return this->ranks[k];
+    }
+    
+    inline usint getNumberOfItems() const { return this->items; }
+    
+    /**
+     * Returns the size of the structure in bytes.
+     */
+    usint reportSize() const;
+    
+  private:
+    usint items;
+    
+    // Boundaries in Eytzinger order, starting from index 1.
+    usint* boundaries;
+    
+    // ranks[k] is the sorted rank of boundaries[k], and ranks[0] is items.
+    usint* ranks;
+    
+    /**
+     * Fill the subtree rooted at k with sorted[next, ...] in order.
+     */
+    void fill(const usint* sorted, usint& next, usint k);
+    
+    // These are not allowed.
+    RangeIndex();
+    RangeIndex(const RangeIndex&);
+    RangeIndex& operator = (const RangeIndex&);
+};
+
 static const usint NUM_BASES = 5;
 
 // This holds the bases in alphabetcal order by reverse complement. This order
@@ -179,6 +237,12 @@ struct FMDPosition
    */
   sint ranges(const RangeVector& ranges) const;
   
+  /**
+   * The same as above, but using a RangeIndex.
+   */
+  sint range(const RangeIndex& ranges) const;
+  sint ranges(const RangeIndex& ranges) const;
+  
 };
 
 /**
@@ -215,6 +279,37 @@ struct Mapping
  */
 std::ostream& operator<< (std::ostream& o, Mapping const& mapping);
 
+/**
+ * Represents an occurrence of a pattern on either strand of a text in an FMD-
+ * index, folded onto the forward strand. Text is the sequence number of the
+ * forward-strand text (always even), offset is the forward-strand position of
+ * the leftmost base of the occurrence, and is_reverse is set if the pattern
+ * occurs on the reverse strand (its reverse complement occurs on the forward
+ * strand at that offset).
+ */
+struct Occurrence
+{
+  usint text;
+  usint offset;
+  bool is_reverse;
+  Occurrence();
+  Occurrence(usint text, usint offset, bool is_reverse);
+  /**
+   * Provide equality comparison for testing.
+   */
+  bool operator==(const Occurrence& other) const;
+  /**
+   * Order by text, offset, and strand.
+   */
+  bool operator<(const Occurrence& other) const;
+};
+
+/**
+ * Provide pretty-printing for Occurrences. See
+ * <http://www.parashift.com/c++-faq/output-operator.html>
+ */
+std::ostream& operator<< (std::ostream& o, Occurrence const& occurrence);
+
 /**
  * A triple to hold the return values from FMD::mapPosition() or
  * FMD::partialMap(). Holds a flag for whether the mapping succeeded or not, an
@@ -373,6 +468,108 @@ class FMDIterator
     
 };
 
+/**
+ * Callback interface for FMD::enumerate(). visit() is called once for every
+ * non-empty suffix tree node at the requested depth, with the pattern and its
+ * SA-space FMDPosition. The pattern is only valid for the duration of the
+ * call. When enumerating with multiple threads, visit() is called concurrently,
+ * and thread identifies the calling thread (0 to threads - 1).
+ */
+class FMDVisitor
+{
+  public:
+    virtual ~FMDVisitor() {}
+    virtual void visit(const std::string& pattern,
+      const FMDPosition& position, usint thread) = 0;
+};
+
+/**
+ * File extension for the k-mer lookup table stored next to an FMD index.
+ */
+const std::string KMER_TABLE_EXTENSION = ".fmd.kmers";
+
+/**
+ * A precomputed table mapping every k-mer over {A, C, G, T} to the
+ * FMDPosition (in BWT coordinates) that a search for it would produce. K-mers
+ * are packed 2 bits per base, so the table has 4^k entries, and each entry is
+ * stored as three bit-packed fields. Searches can use it to jump straight to
+ * depth k instead of paying for k extensions. K-mers containing N or any other
+ * character are not in the table, and the caller must fall back to extending.
+ */
+class KmerTable
+{
+  public:
+    /**
+     * The largest supported k. At this depth the table has 4^14 entries.
+     */
+    static const usint MAX_K = 14;
+
+    /**
+     * Build the table for the given FMD index by enumerating its suffix tree
+     * with an FMDIterator at depth k.
+     */
+    KmerTable(const FMD& parent, usint k);
+
+    /**
+     * Load a table written with writeTo() for the index with the given base
+     * name.
+     */
+    explicit KmerTable(const std::string& base_name);
+
+    ~KmerTable();
+
+    void writeTo(const std::string& base_name) const;
+
+    inline bool isOk() const { return this->ok; }
+    inline usint getK() const { return this->k; }
+
+    /**
+     * Look up the k-mer pattern[start, start + k - 1]. Returns false if the
+     * k-mer cannot be looked up (it runs past the end of the pattern or
+     * contains a character other than A, C, G or T). Otherwise stores the
+     * FMDPosition for the k-mer (in BWT coordinates, possibly empty) in result
+     * and returns true.
+     */
+    bool lookup(const std::string& pattern, usint start, FMDPosition& result)
+      const;
+
+    /**
+     * Returns the size of the table in bytes.
+     */
+    usint reportSize() const;
+
+    /**
+     * Return the 2-bit code of a base, or 4 if it is not one of A, C, G, T.
+     */
+    static inline usint encode(char base)
+    {
+      switch(base)
+      {
+        case 'A': return 0;
+        case 'C': return 1;
+        case 'G': return 2;
+        case 'T': return 3;
+        default:  return 4;
+      }
+    }
+
+  private:
+    usint k;
+
+    // Forward starts, reverse starts, and lengths (end_offset + 1) of the
+    // k-mer ranges. A length of 0 marks a k-mer that does not occur.
+    ReadBuffer* forward_starts;
+    ReadBuffer* reverse_starts;
+    ReadBuffer* lengths;
+
+    bool ok;
+
+    // These are not allowed.
+    KmerTable();
+    KmerTable(const KmerTable&);
+    KmerTable& operator = (const KmerTable&);
+};
+
 /**
  * Defines an RLCSA index derivative that represents an FMD-index: an index of
  * DNA sequences (over the alphabet {A, C, G, T, N}) where all texts are present
@@ -392,7 +589,28 @@ class FMD : public RLCSA
   public:
     // We can only be constructed on a previously generated RLCSA index that
     // just happens to meet our requirements.
+    // If a k-mer table has been written next to the index, it is loaded as
+    // well and used to skip the first k steps of searches.
     explicit FMD(const std::string& base_name, bool print = false);
+    ~FMD();
+    
+    /**
+     * Get the k-mer lookup table in use, or NULL if there is none.
+     */
+    inline const KmerTable* getKmerTable() const { return this->kmers; }
+    
+    /**
+     * Replace the k-mer lookup table. The FMD takes ownership of the table.
+     * Passing NULL disables the table.
+     */
+    void setKmerTable(KmerTable* table);
+    
+    /**
+     * Count occurrences of a pattern with backward search, like RLCSA::count,
+     * but using the k-mer table for the last k characters if available.
+     * Returns an SA range.
+     */
+    pair_type count(const std::string& pattern) const;
     
     /**
      * Extend a search by a character, either backward or forward. Ranges are in
@@ -416,6 +634,36 @@ class FMD : public RLCSA
     FMDPosition fmdCount(const std::string& pattern, bool backward = true)
       const;
       
+    /**
+     * Find all strings within the given number of mismatches (or edit
+     * operations, if edits is set) from the pattern. Uses bidirectional search
+     * schemes: the pattern is split into parts, and each search of the scheme
+     * matches the parts in a different order with per-part error bounds, which
+     * prunes much better than plain backtracking. Returns SA-space
+     * FMDPositions sorted by forward start, with duplicate and nested forward
+     * intervals merged.
+     */
+    std::vector<FMDPosition> fmdApproximateCount(const std::string& pattern,
+      usint errors, bool edits = false) const;
+      
+    /**
+     * Locate the occurrences of a pattern of the given length on both strands,
+     * given its SA-space FMDPosition, and fold them onto the forward-strand
+     * texts. Assumes that sequence 2i + 1 is the reverse complement of
+     * sequence 2i. Only the forward interval is located: an occurrence in a
+     * reverse complement text is a reverse-strand occurrence in the
+     * corresponding forward text, so the reverse interval would only report
+     * the same occurrences again. Results are sorted.
+     */
+    std::vector<Occurrence> locateFolded(const FMDPosition& position,
+      usint pattern_length) const;
+    
+    /**
+     * Count the pattern with fmdCount() and locate its occurrences on both
+     * strands as above.
+     */
+    std::vector<Occurrence> locateFolded(const std::string& pattern) const;
+      
     /**
      * Do backwards search until you find nothing or exactly one thing, or hit
      * the end of the pattern. Return the resulting range in SA coordinates, and
@@ -463,6 +711,12 @@ class FMD : public RLCSA
     MapAttemptResult mapPosition(const RangeVector& ranges, 
       const std::string& pattern, usint index) const;
       
+    /**
+     * The same as above, but using a RangeIndex built from the range vector.
+     */
+    MapAttemptResult mapPosition(const RangeIndex& ranges,
+      const std::string& pattern, usint index) const;
+      
     /**
      * Attempt to map each base in the query string to a (text, position) pair.
      * The vector returned will have one entry for each character in the
@@ -495,6 +749,13 @@ class FMD : public RLCSA
     std::vector<sint> map(const RangeVector& ranges,
       const std::string& query, usint start = 0, sint length = -1) const;
       
+    /**
+     * The same as above, but using a RangeIndex built from the range vector,
+     * which makes the range checks much cheaper.
+     */
+    std::vector<sint> map(const RangeIndex& ranges,
+      const std::string& query, usint start = 0, sint length = -1) const;
+      
     /**
      * Attempt to map each base in the query string to a (text, position) pair.
      * The vector returned will have one entry for each character in the
@@ -535,6 +796,16 @@ class FMD : public RLCSA
      */
     iterator end(usint depth, bool reportDeadEnds=false) const;
     
+    /**
+     * Visit all suffix tree nodes at the given depth, like iterating from
+     * begin(depth) to end(depth), but in parallel. The tree is partitioned by
+     * the first few bases, and each thread does a depth-first search of its own
+     * subtrees without copying the pattern. Subtrees are visited in
+     * alphabetical order within a partition, but partitions may be visited in
+     * any order. Depth may not be 0.
+     */
+    void enumerate(usint depth, FMDVisitor& visitor, usint threads = 1) const;
+    
     /**
      * Return a pair of the number of extends and number of restarts that
      * occurred in mapping operations on any FMD since the last call to
@@ -552,6 +823,47 @@ class FMD : public RLCSA
     static usint restarts;
       
   private:
+    /**
+     * Optional k-mer lookup table. Owned by the FMD.
+     */
+    KmerTable* kmers;
+    
+    /**
+     * Visit every non-empty node at the given depth below the given BWT-space
+     * position, which is the position of the pattern. The pattern is extended
+     * and restored in place.
+     */
+    void enumerateFrom(const FMDPosition& position, std::string& pattern,
+      usint depth, FMDVisitor& visitor, usint thread) const;
+    
+    /**
+     * Implementations of mapPosition() and map() on ranges, for both
+     * RangeVectors and RangeIndexes.
+     */
+    template<class Ranges>
+    MapAttemptResult mapPositionToRanges(const Ranges& ranges,
+      const std::string& pattern, usint index) const;
+    template<class Ranges>
+    std::vector<sint> mapToRanges(const Ranges& ranges,
+      const std::string& query, usint start, sint length) const;
+    
+    /**
+     * A search scheme for approximate search: pattern part borders, the order
+     * in which to match the parts, and the lower and upper bounds for the
+     * cumulative number of errors after each part. Defined in fmd.cpp.
+     */
+    struct SearchScheme;
+    
+    /**
+     * Run the given search scheme from the given BWT-space position, which
+     * matches pattern[left, right - 1] with the given number of errors. Step
+     * is the index of the current part in the scheme order.
+     */
+    void approximateSearch(const SearchScheme& scheme,
+      const std::string& pattern, const FMDPosition& position, usint step,
+      usint left, usint right, usint errors, bool edits,
+      std::vector<FMDPosition>& results) const;
+    
     /**
      * Get an FMDPosition covering the whole SA.
      */
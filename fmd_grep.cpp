@@ -6,17 +6,18 @@
 using namespace CSA;
 
 
-enum mode_type { COUNT, TOTAL, START, RELATIVE, DISPLAY, MAPPING, CONTEXT };
+enum mode_type { COUNT, TOTAL, START, RELATIVE, FOLDED, DISPLAY, MAPPING, CONTEXT };
 
 void print_results(pair_type result_range, const FMD& fmd, mode_type mode, usint pattern_length, usint context);
 
 void printUsage()
 {
-  std::cout << "Usage: fmd_grep [-c|-t|-s|-r|-NUM] pattern base_name" << std::endl;
+  std::cout << "Usage: fmd_grep [-c|-t|-s|-r|-f|-m|-NUM] pattern base_name" << std::endl;
   std::cout << "  -c    print the number of matching sequences" << std::endl;
   std::cout << "  -t    print the total number of occurrences" << std::endl;
   std::cout << "  -s    print the start positions of matches" << std::endl;
   std::cout << "  -r    print the relative start positions of matches (sequence, position)" << std::endl;
+  std::cout << "  -f    print the occurrences on both strands of the forward texts (text, position, strand)" << std::endl;
   std::cout << "  -m    map the pattern and print relative position for each mapped base" << std::endl;
   std::cout << "  -NUM  display NUM characters of leading and trailing context instead of" << std::endl;
   std::cout << "        the entire line" << std::endl;
@@ -54,6 +55,10 @@ int main(int argc, char** argv)
     {
       mode = RELATIVE;
     }
+    else if(std::string("-f").compare(argv[1]) == 0)
+    {
+      mode = FOLDED;
+    }
     else if(std::string("-m").compare(argv[1]) == 0)
     {
       mode = MAPPING;
@@ -114,6 +119,17 @@ int main(int argc, char** argv)
     }
     
   }
+  else if(mode == FOLDED)
+  {
+    // Locate only the forward interval and fold the occurrences in the reverse
+    // complement texts onto the forward texts.
+    std::vector<Occurrence> occurrences = fmd.locateFolded(pattern);
+    for(usint i = 0; i < occurrences.size(); i++)
+    {
+      std::cout << occurrences[i].text << ", " << occurrences[i].offset <<
+        ", " << (occurrences[i].is_reverse ? "-" : "+") << std::endl;
+    }
+  }
   else
   {
     // All the other modes are just counting/finding the occurrences of the
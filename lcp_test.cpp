@@ -5,6 +5,7 @@
 #include <iostream>
 
 #include "rlcsa.h"
+#include "lcparray.h"
 #include "misc/utils.h"
 
 
@@ -21,7 +22,8 @@ int main(int argc, char** argv)
     std::cout << "Supported modes:" << std::endl;
     std::cout << "c -- Count the number of steps" << std::endl;
     std::cout << "d -- Direct LCP" << std::endl;
-    std::cout << "p -- PLCP" << std::endl;
+    std::cout << "p -- PLCP (LCPArray)" << std::endl;
+    std::cout << "q -- Query runs of " << LCPArray::CACHE_SIZE << " consecutive positions" << std::endl;
     std::cout << "s -- Sampled LCP" << std::endl;
     std::cout << "l -- Locate" << std::endl;
     std::cout << "v -- Verify results" << std::endl;
@@ -44,6 +46,7 @@ int main(int argc, char** argv)
   bool mode_sampled = (mode_string.find('s') != std::string::npos);
   bool mode_locate  = (mode_string.find('l') != std::string::npos);
   bool mode_verify  = (mode_string.find('v') != std::string::npos);
+  bool sequential   = (mode_string.find('q') != std::string::npos);
   if(steps) { mode_verify = false; }
   std::cout << "Modes: ";
   if(steps)        { std::cout << "steps "; }
@@ -51,6 +54,7 @@ int main(int argc, char** argv)
   if(mode_plcp)    { std::cout << "plcp "; modes++; }
   if(mode_sampled) { std::cout << "sampled "; modes++; }
   if(mode_locate)  { std::cout << "locate "; }
+  if(sequential)   { std::cout << "sequential "; }
   if(mode_verify)  { std::cout << "verify"; }
   std::cout << std::endl;
 
@@ -72,19 +76,17 @@ int main(int argc, char** argv)
   rlcsa.printInfo();
   rlcsa.reportSize(true);
 
-  PLCPVector* plcp = 0;
+  LCPArray* plcp = 0;
   if(mode_plcp)
   {
-    std::string plcp_name = base_name + PLCP_EXTENSION;
-    std::ifstream plcp_file(plcp_name.c_str(), std::ios_base::binary);
-    if(!plcp_file)
+    plcp = new LCPArray(rlcsa, base_name);
+    if(!(plcp->isOk()))
     {
       std::cerr << "Error: Cannot open PLCP file!" << std::endl;
+      delete plcp;
       return 3;
     }
-    plcp = new PLCPVector(plcp_file);
     std::cout << "PLCP:            " << (plcp->reportSize() / (double)MEGABYTE) << " MB" << std::endl;
-    plcp_file.close();
   }
 
   LCPSamples* lcp = 0;
@@ -112,7 +114,8 @@ int main(int argc, char** argv)
   usint* results4 = new usint[queries];
   for(usint i = 0; i < queries; i++)
   {
-    positions[i] = rand() % rlcsa.getSize();
+    if(sequential && i % LCPArray::CACHE_SIZE > 0) { positions[i] = std::min(positions[i - 1] + 1, rlcsa.getSize() - 1); }
+    else { positions[i] = rand() % rlcsa.getSize(); }
   }
   double start, time;
   usint total;
@@ -139,21 +142,20 @@ int main(int argc, char** argv)
   if(mode_plcp)
   {
     std::cout << "Using PLCP:" << std::endl;
-    PLCPVector::Iterator iter(*plcp);
     for(usint j = 0; j < runs; j++)
     {
       total = 0;
       start = readTimer();
       for(usint i = 0; i < queries; i++)
       {
-        usint pos = rlcsa.locate(positions[i], steps);
-        total += pos;
-        results2[i] = iter.select(pos) - 2 * pos;
+        if(steps) { total += rlcsa.locate(positions[i], true); }
+        else      { results2[i] = plcp->lcp(positions[i]); total += results2[i]; }
       }
       time = readTimer() - start;
       std::cout << queries << " queries in " << time << " seconds (" << (queries / time) << " / s)" << std::endl;
     }
     if(steps) { std::cout << total << " steps (" << (((double)total) / queries) << " / query)" << std::endl; }
+    else      { std::cout << plcp->getCacheHits() << " cache hits" << std::endl; }
     std::cout << std::endl;
   }
 
@@ -0,0 +1,96 @@
+#include <fstream>
+#include <iostream>
+
+#include "lcparray.h"
+
+
+namespace CSA
+{
+
+
+LCPArray::LCPArray(const RLCSA& _rlcsa, const std::string& base_name) :
+  rlcsa(_rlcsa), plcp_vector(0), iter(0), owns_plcp(true),
+  cache_range(EMPTY_PAIR), prev_query(0), cache_hits(0),
+  ok(false)
+{
+  std::string plcp_name = base_name + PLCP_EXTENSION;
+  std::ifstream plcp_file(plcp_name.c_str(), std::ios_base::binary);
+  if(!plcp_file)
+  {
+    std::cerr << "LCPArray: Error opening PLCP file " << plcp_name << "!" << std::endl;
+    return;
+  }
+  this->plcp_vector = new PLCPVector(plcp_file);
+  plcp_file.close();
+
+  this->initialize();
+}
+
+LCPArray::LCPArray(const RLCSA& _rlcsa, const PLCPVector& _plcp) :
+  rlcsa(_rlcsa), plcp_vector(&_plcp), iter(0), owns_plcp(false),
+  cache_range(EMPTY_PAIR), prev_query(0), cache_hits(0),
+  ok(false)
+{
+  this->initialize();
+}
+
+LCPArray::~LCPArray()
+{
+  delete this->iter; this->iter = 0;
+  if(this->owns_plcp) { delete this->plcp_vector; }
+  this->plcp_vector = 0;
+}
+
+void
+LCPArray::initialize()
+{
+  if(!(this->rlcsa.isOk()) || !(this->rlcsa.supportsLocate()))
+  {
+    std::cerr << "LCPArray: Error: The index does not support locate!" << std::endl;
+    return;
+  }
+  if(this->plcp_vector->getSize() < 2 * this->rlcsa.getTextSize())
+  {
+    std::cerr << "LCPArray: Error: PLCP does not match the index!" << std::endl;
+    return;
+  }
+
+  this->iter = new PLCPVector::Iterator(*(this->plcp_vector));
+  this->ok = true;
+}
+
+usint
+LCPArray::reportSize() const
+{
+  usint bytes = sizeof(*this);
+  if(this->owns_plcp && this->plcp_vector != 0) { bytes += this->plcp_vector->reportSize(); }
+  return bytes;
+}
+
+//--------------------------------------------------------------------------
+
+usint
+LCPArray::lcp(usint sa_index)
+{
+  if(!(this->isOk()) || sa_index >= this->getSize()) { return 0; }
+
+  usint pos = 0;
+  if(sa_index >= this->cache_range.first && sa_index <= this->cache_range.second)
+  {
+    pos = this->cache[sa_index - this->cache_range.first];
+    this->cache_hits++;
+  }
+  else if(sa_index == this->prev_query + 1)
+  {
+    this->cache_range = pair_type(sa_index, std::min(sa_index + CACHE_SIZE, this->getSize()) - 1);
+    this->rlcsa.locate(this->cache_range, this->cache);
+    pos = this->cache[0];
+  }
+  else { pos = this->rlcsa.locate(sa_index); }
+  this->prev_query = sa_index;
+
+  return this->plcp(pos);
+}
+
+
+} // namespace CSA
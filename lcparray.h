@@ -0,0 +1,77 @@
+#ifndef LCPARRAY_H
+#define LCPARRAY_H
+
+#include "rlcsa.h"
+
+
+namespace CSA
+{
+
+
+/*
+  LCP array access using PLCP: LCP[i] = PLCP[SA[i]] = select(SA[i]) - 2 * SA[i] in the
+  PLCP vector built with build_plcp. Each query costs one locate() and one select(),
+  instead of O(sample_rate) Psi steps in RLCSA::lcp() and RLCSA::lcpDirect().
+
+  Scanning consecutive positions is common, so when a query is for the position after the
+  previous query, the next CACHE_SIZE SA values are located with a single range locate and
+  later queries in that range are answered from the cache. If the text position is already
+  known, plcp() skips locate entirely.
+
+  An LCPArray is not thread-safe, as it contains the cache. Use one for each thread.
+*/
+
+class LCPArray
+{
+  public:
+    const static usint CACHE_SIZE = 64;
+
+    // Loads base_name.plcp. The index must support locate.
+    LCPArray(const RLCSA& _rlcsa, const std::string& base_name);
+
+    // Uses an existing PLCP vector that is not owned by the LCPArray.
+    LCPArray(const RLCSA& _rlcsa, const PLCPVector& _plcp);
+
+    ~LCPArray();
+
+    // Returns LCP[sa_index] or 0 if sa_index >= getSize().
+    usint lcp(usint sa_index);
+
+    // Returns PLCP[text_position] = LCP[inverseLocate(text_position)].
+    inline usint plcp(usint text_position)
+    {
+      return this->iter->select(text_position) - 2 * text_position;
+    }
+
+    inline bool isOk() const { return this->ok; }
+    inline usint getSize() const { return this->rlcsa.getSize(); }
+    inline usint getCacheHits() const { return this->cache_hits; }
+
+    // Does not include the size of the index.
+    usint reportSize() const;
+
+  private:
+    const RLCSA&          rlcsa;
+    const PLCPVector*     plcp_vector;
+    PLCPVector::Iterator* iter;
+    bool                  owns_plcp;
+
+    usint     cache[CACHE_SIZE];
+    pair_type cache_range;
+    usint     prev_query, cache_hits;
+
+    bool ok;
+
+    void initialize();
+
+    // These are not allowed.
+    LCPArray();
+    LCPArray(const LCPArray&);
+    LCPArray& operator = (const LCPArray&);
+};
+
+
+} // namespace CSA
+
+
+#endif // LCPARRAY_H
@@ -0,0 +1,127 @@
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+
+#include "rlcsa.h"
+#include "cst.h"
+#include "misc/utils.h"
+
+
+using namespace CSA;
+
+
+/*
+  This program computes the matching statistics of each query (one per line) against
+  the collection using the compressed suffix tree. The index must support locate, and
+  the PLCP and the CST must have been built with build_plcp and build_cst. With -c, the
+  results are verified with repeated count() queries.
+*/
+
+
+usint countMatchingStatistics(const RLCSA& rlcsa, const std::string& query, std::vector<usint>& result);
+
+
+int
+main(int argc, char** argv)
+{
+  std::cout << "Matching statistics" << std::endl;
+  bool verify = false;
+  int arg = 1;
+  if(argc > 1 && std::string(argv[1]) == "-c") { verify = true; arg++; }
+  if(argc < arg + 2)
+  {
+    std::cout << "Usage: matching_stats [-c] base_name queries [threads]" << std::endl;
+    return 1;
+  }
+
+  std::string base_name = argv[arg], queries_name = argv[arg + 1];
+  usint threads = (argc > arg + 2 ? std::max(atoi(argv[arg + 2]), 1) : 1);
+  std::cout << "Base name: " << base_name << std::endl;
+  std::cout << "Queries: " << queries_name << std::endl;
+  std::cout << "Threads: " << threads << std::endl;
+  if(verify) { std::cout << "Verifying with count()" << std::endl; }
+  std::cout << std::endl;
+
+  RLCSA rlcsa(base_name, false);
+  if(!rlcsa.isOk() || !rlcsa.supportsLocate()) { return 2; }
+  rlcsa.reportSize(true);
+
+  std::string plcp_name = base_name + PLCP_EXTENSION;
+  std::ifstream plcp_file(plcp_name.c_str(), std::ios_base::binary);
+  if(!plcp_file)
+  {
+    std::cerr << "Error: Cannot open PLCP file " << plcp_name << "!" << std::endl;
+    return 3;
+  }
+  PLCPVector plcp(plcp_file);
+  plcp_file.close();
+  CST cst(rlcsa, plcp, base_name);
+  if(!cst.isOk()) { return 4; }
+  cst.reportSize(true);
+
+  std::ifstream queries_file(queries_name.c_str(), std::ios_base::binary);
+  if(!queries_file)
+  {
+    std::cerr << "Error: Cannot open query file " << queries_name << "!" << std::endl;
+    return 5;
+  }
+  std::vector<std::string> queries;
+  readRows(queries_file, queries, true);
+  queries_file.close();
+
+  double start = readTimer();
+  std::vector<std::vector<usint> > results;
+  cst.matchingStatistics(queries, results, threads);
+  double seconds = readTimer() - start;
+
+  usint total_length = 0, total_ms = 0;
+  for(usint i = 0; i < queries.size(); i++)
+  {
+    total_length += queries[i].length();
+    for(usint j = 0; j < results[i].size(); j++) { total_ms += results[i][j]; }
+  }
+  std::cout << queries.size() << " queries of total length " << total_length << std::endl;
+  std::cout << "Average matching statistic: " << (total_ms / (double)std::max(total_length, (usint)1)) << std::endl;
+  std::cout << "Time: " << seconds << " seconds (" << (total_length / seconds) << " positions / s)" << std::endl;
+  std::cout << std::endl;
+
+  if(verify)
+  {
+    usint errors = 0, count_queries = 0;
+    start = readTimer();
+    for(usint i = 0; i < queries.size(); i++)
+    {
+      std::vector<usint> expected;
+      count_queries += countMatchingStatistics(rlcsa, queries[i], expected);
+      if(expected != results[i]) { errors++; }
+    }
+    seconds = readTimer() - start;
+    std::cout << "count(): " << count_queries << " queries in " << seconds << " seconds" << std::endl;
+    std::cout << errors << " queries with different results" << std::endl;
+    std::cout << std::endl;
+  }
+
+  return 0;
+}
+
+
+// Computes the matching statistics with one count() query per extension. Returns the
+// number of count() queries.
+usint
+countMatchingStatistics(const RLCSA& rlcsa, const std::string& query, std::vector<usint>& result)
+{
+  usint queries = 0, len = 0;
+  result.resize(query.length());
+  for(usint i = 0; i < query.length(); i++)
+  {
+    len = (len > 0 ? len - 1 : 0);  // MS[i] >= MS[i - 1] - 1.
+    while(i + len < query.length())
+    {
+      queries++;
+      if(isEmpty(rlcsa.count(query.substr(i, len + 1)))) { break; }
+      len++;
+    }
+    result[i] = len;
+  }
+  return queries;
+}
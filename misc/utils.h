@@ -134,6 +134,22 @@ sequentialSort(Iterator first, Iterator last, const Compare& comp)
   #endif
 }
 
+// Returns the leftmost minimum. The parallel version may return any minimum.
+template <class Iterator>
+Iterator
+sequentialMinElement(Iterator first, Iterator last)
+{
+  #ifdef MULTITHREAD_SUPPORT
+    #ifdef _GLIBCXX_PARALLEL
+      return std::min_element(first, last, __gnu_parallel::sequential_tag());
+    #else
+      return std::min_element(first, last, mcstl::sequential_tag());
+    #endif
+  #else
+    return std::min_element(first, last);
+  #endif
+}
+
 template<class T>
 void
 removeDuplicates(std::vector<T>* vec, bool parallel = true)
@@ -0,0 +1,116 @@
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "rlcsa.h"
+#include "misc/utils.h"
+
+
+using namespace CSA;
+
+
+/*
+  This program checks the Psi encodings against the index as stored. For each encoding,
+  including the hybrid one, a copy of the index is re-encoded in memory, and the number
+  of runs, count() for patterns sampled from the collection and for random strings, and
+  locate() for the occurrences of the sampled patterns must match the original index.
+*/
+
+
+int
+main(int argc, char** argv)
+{
+  std::cout << "Psi encoding test" << std::endl;
+  if(argc < 2)
+  {
+    std::cout << "Usage: psi_test base_name [patterns [length]]" << std::endl;
+    return 1;
+  }
+
+  std::string base_name = argv[1];
+  usint patterns = (argc > 2 ? atoi(argv[2]) : 1000);
+  usint len = (argc > 3 ? std::max(atoi(argv[3]), 1) : 6);
+  std::cout << "Base name: " << base_name << std::endl;
+  std::cout << "Patterns: " << patterns << std::endl;
+  std::cout << "Pattern length: " << len << std::endl;
+  std::cout << std::endl;
+
+  RLCSA original(base_name, false);
+  if(!original.isOk()) { return 2; }
+  std::cout << "Original encoding: " << PsiVector::encodingName(original.getPsiEncoding()) << std::endl;
+  std::cout << std::endl;
+
+  // Half of the patterns occur in the collection, while the other half are random
+  // strings over the alphabet.
+  std::vector<uchar> chars;
+  for(usint c = 0; c < CHARS; c++)
+  {
+    if(!isEmpty(original.getCharRange(c))) { chars.push_back(c); }
+  }
+  std::vector<std::string> rows;
+  pair_type sa_range = original.getSARange();
+  uchar* buffer = new uchar[len];
+  std::srand(0xDEADBEEF);
+  for(usint i = 0; i < patterns; i++)
+  {
+    if(i % 2 == 0)
+    {
+      usint index = sa_range.first + ((usint)std::rand() * RAND_MAX + std::rand()) % length(sa_range);
+      usint found = original.displayFromPosition(index, len, buffer);
+      rows.push_back(std::string((char*)buffer, found));
+    }
+    else
+    {
+      std::string row(len, 0);
+      for(usint j = 0; j < len; j++) { row[j] = chars[std::rand() % chars.size()]; }
+      rows.push_back(row);
+    }
+  }
+  delete[] buffer; buffer = 0;
+
+  usint original_runs = original.countRuns();
+  std::vector<pair_type> ranges(rows.size());
+  std::vector<std::vector<usint> > occurrences(rows.size());
+  for(usint i = 0; i < rows.size(); i++)
+  {
+    ranges[i] = original.count(rows[i]);
+    if(isEmpty(ranges[i])) { continue; }
+    usint* res = original.locate(ranges[i]);
+    occurrences[i].assign(res, res + length(ranges[i]));
+    delete[] res; res = 0;
+  }
+
+  usint failures = 0;
+  for(usint encoding = 0; encoding <= PsiVector::HYBRID_ENCODING; encoding++)
+  {
+    RLCSA rlcsa(base_name, false);
+    if(!rlcsa.isOk()) { return 2; }
+    rlcsa.setPsiEncoding(encoding);
+
+    double start = readTimer();
+    usint runs = rlcsa.countRuns();
+    usint count_errors = 0, locate_errors = 0;
+    for(usint i = 0; i < rows.size(); i++)
+    {
+      pair_type range = rlcsa.count(rows[i]);
+      if(range != ranges[i] && !(isEmpty(range) && isEmpty(ranges[i]))) { count_errors++; continue; }
+      if(isEmpty(range)) { continue; }
+      usint* res = rlcsa.locate(range);
+      if(!std::equal(occurrences[i].begin(), occurrences[i].end(), res)) { locate_errors++; }
+      delete[] res; res = 0;
+    }
+    double seconds = readTimer() - start;
+
+    bool ok = (runs == original_runs && count_errors == 0 && locate_errors == 0);
+    std::cout << PsiVector::encodingName(encoding) << ": " << (ok ? "ok" : "FAILED")
+              << " (" << rlcsa.reportSize() << " bytes, " << runs << " runs, "
+              << count_errors << " count errors, " << locate_errors << " locate errors, "
+              << seconds << " seconds)" << std::endl;
+    if(!ok) { failures++; }
+  }
+  std::cout << std::endl;
+
+  return (failures > 0 ? 3 : 0);
+}
@@ -0,0 +1,398 @@
+#include <algorithm>
+#include <iostream>
+
+#include "psivector.h"
+#include "bits/vectors.h"
+
+
+namespace CSA
+{
+
+
+const char*
+PsiVector::encodingName(usint encoding)
+{
+  switch(encoding)
+  {
+    case RLE_ENCODING:      return "rle";
+    case NIBBLE_ENCODING:   return "nibble";
+    case DELTA_ENCODING:    return "delta";
+    case SUCCINCT_ENCODING: return "succinct";
+    case HYBRID_ENCODING:   return "hybrid";
+    default:                return "unknown";
+  }
+}
+
+//--------------------------------------------------------------------------
+
+// These are the code lengths used by WriteBuffer.
+
+inline usint
+deltaCodeLength(usint value)
+{
+  usint len = length(value);
+  usint llen = length(len);
+  return (len + llen + llen - 2);
+}
+
+inline usint
+nibbleCodeLength(usint value)
+{
+  usint b = 0;
+  value--;
+  do { b += 4; value >>= 3; } while(value > 0);
+  return b;
+}
+
+PsiVector::Statistics::Statistics(usint _universe_size) :
+  universe_size(_universe_size),
+  size(0), items(0), run_length(0)
+{
+  for(usint i = 0; i < ENCODINGS; i++) { this->bits[i] = 0; }
+}
+
+void
+PsiVector::Statistics::addRun(usint start, usint len)
+{
+  if(len == 0 || (this->items > 0 && start < this->size)) { return; }
+
+  if(this->items > 0 && start == this->size)
+  {
+    usint new_length = this->run_length + len;
+    this->bits[RLE_ENCODING] += deltaCodeLength(new_length) - deltaCodeLength(this->run_length);
+    this->bits[NIBBLE_ENCODING] += nibbleCodeLength(new_length) - nibbleCodeLength(this->run_length);
+    this->bits[DELTA_ENCODING] += len;
+    this->run_length = new_length;
+  }
+  else
+  {
+    usint diff = start + 1 - this->size;
+    this->bits[RLE_ENCODING] += deltaCodeLength(diff) + deltaCodeLength(len);
+    this->bits[NIBBLE_ENCODING] += nibbleCodeLength(diff) + nibbleCodeLength(len);
+    this->bits[DELTA_ENCODING] += deltaCodeLength(diff) + len - 1;
+    this->run_length = len;
+  }
+
+  this->size = start + len;
+  this->items += len;
+}
+
+usint
+PsiVector::Statistics::estimate(usint encoding) const
+{
+  if(encoding == SUCCINCT_ENCODING) { return std::max(this->universe_size, this->size); }
+  if(encoding < ENCODINGS) { return this->bits[encoding]; }
+  return 0;
+}
+
+usint
+PsiVector::Statistics::bestEncoding(usint slack) const
+{
+  // Encodings from the fastest to the slowest in count(), which uses rank() for LF.
+  const usint order[ENCODINGS] = { SUCCINCT_ENCODING, NIBBLE_ENCODING, RLE_ENCODING, DELTA_ENCODING };
+
+  usint smallest = this->estimate(order[0]);
+  for(usint i = 1; i < ENCODINGS; i++) { smallest = std::min(smallest, this->estimate(order[i])); }
+
+  usint limit = smallest + (smallest / 100) * slack;
+  for(usint i = 0; i < ENCODINGS; i++)
+  {
+    if(this->estimate(order[i]) <= limit) { return order[i]; }
+  }
+  return DEFAULT_ENCODING;
+}
+
+usint
+PsiVector::chooseEncoding(const PsiVector& vector, usint slack)
+{
+  Statistics statistics(vector.getSize());
+
+  Iterator iter(vector);
+  usint items = vector.getNumberOfItems();
+  pair_type run = iter.selectRun(0, items);
+  usint found = run.second + 1;
+  statistics.addRun(run.first, run.second + 1);
+  while(found < items)
+  {
+    run = iter.selectNextRun(items);
+    found += run.second + 1;
+    statistics.addRun(run.first, run.second + 1);
+  }
+
+  return statistics.bestEncoding(slack);
+}
+
+//--------------------------------------------------------------------------
+
+PsiVector::Encoder::Encoder(usint block_bytes, usint _encoding) :
+  encoding(_encoding), encoder(0)
+{
+  switch(this->encoding)
+  {
+    case NIBBLE_ENCODING:   this->encoder = new NibbleEncoder(block_bytes); break;
+    case DELTA_ENCODING:    this->encoder = new DeltaEncoder(block_bytes); break;
+    case SUCCINCT_ENCODING: this->encoder = new SuccinctEncoder(block_bytes); break;
+    default:                this->encoding = RLE_ENCODING; this->encoder = new RLEEncoder(block_bytes); break;
+  }
+}
+
+PsiVector::Encoder::~Encoder()
+{
+  switch(this->encoding)
+  {
+    case NIBBLE_ENCODING:   delete (NibbleEncoder*)(this->encoder); break;
+    case DELTA_ENCODING:    delete (DeltaEncoder*)(this->encoder); break;
+    case SUCCINCT_ENCODING: delete (SuccinctEncoder*)(this->encoder); break;
+    default:                delete (RLEEncoder*)(this->encoder); break;
+  }
+  this->encoder = 0;
+}
+
+void
+PsiVector::Encoder::setBit(usint value)
+{
+  switch(this->encoding)
+  {
+    case NIBBLE_ENCODING:   ((NibbleEncoder*)(this->encoder))->setBit(value); break;
+    case DELTA_ENCODING:    ((DeltaEncoder*)(this->encoder))->setBit(value); break;
+    case SUCCINCT_ENCODING: ((SuccinctEncoder*)(this->encoder))->setBit(value); break;
+    default:                ((RLEEncoder*)(this->encoder))->setBit(value); break;
+  }
+}
+
+void
+PsiVector::Encoder::setRun(usint start, usint len)
+{
+  switch(this->encoding)
+  {
+    case NIBBLE_ENCODING:   ((NibbleEncoder*)(this->encoder))->setRun(start, len); break;
+    case DELTA_ENCODING:    ((DeltaEncoder*)(this->encoder))->setRun(start, len); break;
+    case SUCCINCT_ENCODING: ((SuccinctEncoder*)(this->encoder))->setRun(start, len); break;
+    default:                ((RLEEncoder*)(this->encoder))->setRun(start, len); break;
+  }
+}
+
+void
+PsiVector::Encoder::addBit(usint value)
+{
+  switch(this->encoding)
+  {
+    case NIBBLE_ENCODING:   ((NibbleEncoder*)(this->encoder))->addBit(value); break;
+    case DELTA_ENCODING:    ((DeltaEncoder*)(this->encoder))->addBit(value); break;
+    case SUCCINCT_ENCODING: ((SuccinctEncoder*)(this->encoder))->addBit(value); break;
+    default:                ((RLEEncoder*)(this->encoder))->addBit(value); break;
+  }
+}
+
+void
+PsiVector::Encoder::addRun(usint start, usint len)
+{
+  switch(this->encoding)
+  {
+    case NIBBLE_ENCODING:   ((NibbleEncoder*)(this->encoder))->addRun(start, len); break;
+    case DELTA_ENCODING:    ((DeltaEncoder*)(this->encoder))->addRun(start, len); break;
+    case SUCCINCT_ENCODING: ((SuccinctEncoder*)(this->encoder))->addRun(start, len); break;
+    default:                ((RLEEncoder*)(this->encoder))->addRun(start, len); break;
+  }
+}
+
+void
+PsiVector::Encoder::flush()
+{
+  switch(this->encoding)
+  {
+    case NIBBLE_ENCODING:   ((NibbleEncoder*)(this->encoder))->flush(); break;
+    case DELTA_ENCODING:    ((DeltaEncoder*)(this->encoder))->flush(); break;
+    case SUCCINCT_ENCODING: ((SuccinctEncoder*)(this->encoder))->flush(); break;
+    default:                ((RLEEncoder*)(this->encoder))->flush(); break;
+  }
+}
+
+//--------------------------------------------------------------------------
+
+PsiVector::PsiVector(std::ifstream& file, usint _encoding) :
+  encoding(_encoding), vector(0)
+{
+  switch(this->encoding)
+  {
+    case NIBBLE_ENCODING:   this->vector = new NibbleVector(file); break;
+    case DELTA_ENCODING:    this->vector = new DeltaVector(file); break;
+    case SUCCINCT_ENCODING: this->vector = new SuccinctVector(file); break;
+    default:                this->encoding = RLE_ENCODING; this->vector = new RLEVector(file); break;
+  }
+}
+
+PsiVector::PsiVector(Encoder& encoder, usint universe_size) :
+  encoding(encoder.encoding), vector(0)
+{
+  switch(this->encoding)
+  {
+    case NIBBLE_ENCODING:
+      this->vector = new NibbleVector(*(NibbleEncoder*)(encoder.encoder), universe_size); break;
+    case DELTA_ENCODING:
+      this->vector = new DeltaVector(*(DeltaEncoder*)(encoder.encoder), universe_size); break;
+    case SUCCINCT_ENCODING:
+      this->vector = new SuccinctVector(*(SuccinctEncoder*)(encoder.encoder), universe_size); break;
+    default:
+      this->vector = new RLEVector(*(RLEEncoder*)(encoder.encoder), universe_size); break;
+  }
+}
+
+PsiVector::PsiVector(const PsiVector& source, usint _encoding, usint block_bytes) :
+  encoding(_encoding), vector(0)
+{
+  Encoder encoder(block_bytes, this->encoding);
+  this->encoding = encoder.getEncoding();
+
+  Iterator iter(source);
+  usint size = source.getSize(), items = source.getNumberOfItems();
+  pair_type run = iter.selectRun(0, items);
+  usint found = run.second + 1;
+  encoder.addRun(run.first, run.second + 1);
+  while(found < items)
+  {
+    run = iter.selectNextRun(items);
+    found += run.second + 1;
+    encoder.addRun(run.first, run.second + 1);
+  }
+  encoder.flush();
+
+  PsiVector temp(encoder, size);
+  this->vector = temp.vector; temp.vector = 0;
+}
+
+PsiVector::PsiVector(BitVector* _vector, usint _encoding) :
+  encoding(_encoding), vector(_vector)
+{
+}
+
+PsiVector::~PsiVector()
+{
+  switch(this->encoding)
+  {
+    case NIBBLE_ENCODING:   delete (NibbleVector*)(this->vector); break;
+    case DELTA_ENCODING:    delete (DeltaVector*)(this->vector); break;
+    case SUCCINCT_ENCODING: delete (SuccinctVector*)(this->vector); break;
+    default:                delete (RLEVector*)(this->vector); break;
+  }
+  this->vector = 0;
+}
+
+BitVector*
+PsiVector::release(PsiVector* wrapper)
+{
+  if(wrapper == 0) { return 0; }
+  BitVector* result = wrapper->vector;
+  wrapper->vector = 0;
+  delete wrapper;
+  return result;
+}
+
+PsiVector*
+PsiVector::merge(PsiVector* first, PsiVector* second, usint* positions, usint n, usint size, usint block_bytes, usint encoding)
+{
+  if(encoding == HYBRID_ENCODING)
+  {
+    if(first == 0 && second == 0) { return 0; }
+    encoding = (first != 0 ? first->encoding : second->encoding);
+    PsiVector* result = merge(first, second, positions, n, size, block_bytes, encoding);
+    if(result == 0) { return 0; }
+
+    usint best = chooseEncoding(*result);
+    if(best != result->encoding)
+    {
+      PsiVector* temp = new PsiVector(*result, best, block_bytes);
+      delete result; result = temp;
+    }
+    return result;
+  }
+
+  if(first != 0 && first->encoding != encoding)
+  {
+    PsiVector* temp = new PsiVector(*first, encoding, block_bytes);
+    delete first; first = temp;
+  }
+  if(second != 0 && second->encoding != encoding)
+  {
+    PsiVector* temp = new PsiVector(*second, encoding, block_bytes);
+    delete second; second = temp;
+  }
+
+  BitVector* result = 0;
+  switch(encoding)
+  {
+    case NIBBLE_ENCODING:
+      result = mergeVectors<NibbleVector, NibbleEncoder, NibbleVector::Iterator>((NibbleVector*)release(first),
+        (NibbleVector*)release(second), positions, n, size, block_bytes);
+      break;
+    case DELTA_ENCODING:
+      result = mergeVectors<DeltaVector, DeltaEncoder, DeltaVector::Iterator>((DeltaVector*)release(first),
+        (DeltaVector*)release(second), positions, n, size, block_bytes);
+      break;
+    case SUCCINCT_ENCODING:
+      result = mergeVectors<SuccinctVector, SuccinctEncoder, SuccinctVector::Iterator>((SuccinctVector*)release(first),
+        (SuccinctVector*)release(second), positions, n, size, block_bytes);
+      break;
+    default:
+      encoding = RLE_ENCODING;
+      result = mergeVectors<RLEVector, RLEEncoder, RLEVector::Iterator>((RLEVector*)release(first),
+        (RLEVector*)release(second), positions, n, size, block_bytes);
+      break;
+  }
+
+  if(result == 0) { return 0; }
+  return new PsiVector(result, encoding);
+}
+
+//--------------------------------------------------------------------------
+
+void
+PsiVector::writeTo(std::ofstream& file) const
+{
+  switch(this->encoding)
+  {
+    case SUCCINCT_ENCODING: ((SuccinctVector*)(this->vector))->writeTo(file); break;
+    default:                this->vector->writeTo(file); break;
+  }
+}
+
+usint
+PsiVector::reportSize() const
+{
+  usint bytes = sizeof(*this);
+  switch(this->encoding)
+  {
+    case NIBBLE_ENCODING:   bytes += ((NibbleVector*)(this->vector))->reportSize(); break;
+    case DELTA_ENCODING:    bytes += ((DeltaVector*)(this->vector))->reportSize(); break;
+    case SUCCINCT_ENCODING: bytes += ((SuccinctVector*)(this->vector))->reportSize(); break;
+    default:                bytes += ((RLEVector*)(this->vector))->reportSize(); break;
+  }
+  return bytes;
+}
+
+void
+PsiVector::strip()
+{
+  switch(this->encoding)
+  {
+    case SUCCINCT_ENCODING: ((SuccinctVector*)(this->vector))->strip(); break;
+    default:                this->vector->strip(); break;
+  }
+}
+
+//--------------------------------------------------------------------------
+
+usint
+PsiVector::Iterator::countRuns()
+{
+  switch(this->encoding)
+  {
+    case NIBBLE_ENCODING:   return this->nibble()->countRuns();
+    case DELTA_ENCODING:    return this->delta()->countRuns();
+    case SUCCINCT_ENCODING: return this->succinct()->countRuns();
+    default:                return this->rle()->countRuns();
+  }
+}
+
+
+} // namespace CSA
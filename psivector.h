@@ -0,0 +1,333 @@
+#ifndef PSIVECTOR_H
+#define PSIVECTOR_H
+
+#include <fstream>
+#include <new>
+
+#include "bits/deltavector.h"
+#include "bits/rlevector.h"
+#include "bits/nibblevector.h"
+#include "bits/succinctvector.h"
+
+
+namespace CSA
+{
+
+
+/*
+  A Psi vector whose encoding is chosen at run time. The vector wraps one of the bit
+  vectors, and each operation dispatches to the specialized code of that encoding with
+  a switch. Because all vectors of an index usually share the encoding, the branch is
+  easy to predict. The encoding is not stored in the vector itself.
+
+  Encodings:
+    RLE_ENCODING       RLEVector (default)
+    NIBBLE_ENCODING    NibbleVector (default with -DUSE_NIBBLE_VECTORS)
+    DELTA_ENCODING     DeltaVector
+    SUCCINCT_ENCODING  SuccinctVector
+
+  HYBRID_ENCODING is not an encoding of a single vector. It tells RLCSA to choose the
+  encoding separately for each character using chooseEncoding().
+*/
+
+class PsiVector
+{
+  public:
+    const static usint RLE_ENCODING      = 0;
+    const static usint NIBBLE_ENCODING   = 1;
+    const static usint DELTA_ENCODING    = 2;
+    const static usint SUCCINCT_ENCODING = 3;
+    const static usint ENCODINGS         = 4;
+    const static usint HYBRID_ENCODING   = ENCODINGS;
+
+    // The fastest encoding within HYBRID_SLACK percent of the smallest one is chosen.
+    const static usint HYBRID_SLACK = 10;
+
+    #ifdef USE_NIBBLE_VECTORS
+    const static usint DEFAULT_ENCODING = NIBBLE_ENCODING;
+    #else
+    const static usint DEFAULT_ENCODING = RLE_ENCODING;
+    #endif
+
+    static const char* encodingName(usint encoding);
+
+//--------------------------------------------------------------------------
+
+    /*
+      Run statistics for choosing the encoding of a vector. The statistics give the
+      total length of the codes each encoding would use, ignoring block boundaries and
+      the index. Adjacent runs are combined, so the 1-bits can also be added one by one.
+    */
+
+    class Statistics
+    {
+      public:
+        explicit Statistics(usint universe_size);
+
+        void addRun(usint start, usint len);  // Runs must be in increasing order.
+
+        usint estimate(usint encoding) const;
+
+        // Returns the fastest encoding whose estimate is within slack percent of the
+        // smallest estimate.
+        usint bestEncoding(usint slack = HYBRID_SLACK) const;
+
+      private:
+        usint universe_size;
+        usint size, items, run_length;
+        usint bits[ENCODINGS];
+    };
+
+    static usint chooseEncoding(const PsiVector& vector, usint slack = HYBRID_SLACK);
+
+//--------------------------------------------------------------------------
+
+    class Encoder
+    {
+      public:
+        Encoder(usint block_bytes, usint _encoding = DEFAULT_ENCODING);
+        ~Encoder();
+
+        void setBit(usint value);
+        void setRun(usint start, usint len);
+
+        void addBit(usint value);
+        void addRun(usint start, usint len);
+        void flush();
+
+        inline usint getEncoding() const { return this->encoding; }
+
+      private:
+        usint          encoding;
+        VectorEncoder* encoder;
+
+        friend class PsiVector;
+
+        // These are not allowed.
+        Encoder();
+        Encoder(const Encoder&);
+        Encoder& operator = (const Encoder&);
+    };
+
+//--------------------------------------------------------------------------
+
+    PsiVector(std::ifstream& file, usint _encoding);
+    PsiVector(Encoder& encoder, usint universe_size);
+
+    // Re-encodes the source vector.
+    PsiVector(const PsiVector& source, usint _encoding, usint block_bytes);
+
+    ~PsiVector();
+
+    /*
+      Merges two vectors using marked positions as in mergeVectors(). The vectors are
+      re-encoded first if they do not use the given encoding. The original vectors are
+      deleted. With HYBRID_ENCODING, the vectors are merged using the encoding of the
+      first vector, and the result is re-encoded if chooseEncoding() prefers another.
+    */
+    static PsiVector* merge(PsiVector* first, PsiVector* second, usint* positions, usint n,
+      usint size, usint block_bytes, usint encoding);
+
+    void writeTo(std::ofstream& file) const;
+
+    inline usint getEncoding() const { return this->encoding; }
+    inline usint getSize() const { return this->vector->getSize(); }
+    inline usint getNumberOfItems() const { return this->vector->getNumberOfItems(); }
+    inline usint getBlockSize() const { return this->vector->getBlockSize(); }
+    inline usint getCompressedSize() const { return this->vector->getCompressedSize(); }
+
+    usint reportSize() const;
+
+    // Removes structures not necessary for merging.
+    void strip();
+
+//--------------------------------------------------------------------------
+
+    class Iterator
+    {
+      public:
+        explicit Iterator(const PsiVector& par) :
+          encoding(par.encoding)
+        {
+          switch(this->encoding)
+          {
+            case NIBBLE_ENCODING:
+              new(this->storage.nibble_storage) NibbleVector::Iterator(*(const NibbleVector*)(par.vector)); break;
+            case DELTA_ENCODING:
+              new(this->storage.delta_storage) DeltaVector::Iterator(*(const DeltaVector*)(par.vector)); break;
+            case SUCCINCT_ENCODING:
+              new(this->storage.succinct_storage) SuccinctVector::Iterator(*(const SuccinctVector*)(par.vector)); break;
+            default:
+              new(this->storage.rle_storage) RLEVector::Iterator(*(const RLEVector*)(par.vector)); break;
+          }
+        }
+
+        ~Iterator()
+        {
+          switch(this->encoding)
+          {
+            case NIBBLE_ENCODING:   this->nibble()->~Iterator(); break;
+            case DELTA_ENCODING:    this->delta()->~Iterator(); break;
+            case SUCCINCT_ENCODING: this->succinct()->~Iterator(); break;
+            default:                this->rle()->~Iterator(); break;
+          }
+        }
+
+        inline usint rank(usint value, bool at_least = false)
+        {
+          switch(this->encoding)
+          {
+            case NIBBLE_ENCODING:   return this->nibble()->rank(value, at_least);
+            case DELTA_ENCODING:    return this->delta()->rank(value, at_least);
+            case SUCCINCT_ENCODING: return this->succinct()->rank(value, at_least);
+            default:                return this->rle()->rank(value, at_least);
+          }
+        }
+
+        inline usint select(usint index)
+        {
+          switch(this->encoding)
+          {
+            case NIBBLE_ENCODING:   return this->nibble()->select(index);
+            case DELTA_ENCODING:    return this->delta()->select(index);
+            case SUCCINCT_ENCODING: return this->succinct()->select(index);
+            default:                return this->rle()->select(index);
+          }
+        }
+
+        inline usint selectNext()
+        {
+          switch(this->encoding)
+          {
+            case NIBBLE_ENCODING:   return this->nibble()->selectNext();
+            case DELTA_ENCODING:    return this->delta()->selectNext();
+            case SUCCINCT_ENCODING: return this->succinct()->selectNext();
+            default:                return this->rle()->selectNext();
+          }
+        }
+
+        inline bool hasNext() const
+        {
+          switch(this->encoding)
+          {
+            case NIBBLE_ENCODING:   return this->nibble()->hasNext();
+            case DELTA_ENCODING:    return this->delta()->hasNext();
+            case SUCCINCT_ENCODING: return this->succinct()->hasNext();
+            default:                return this->rle()->hasNext();
+          }
+        }
+
+        inline pair_type valueBefore(usint value)
+        {
+          switch(this->encoding)
+          {
+            case NIBBLE_ENCODING:   return this->nibble()->valueBefore(value);
+            case DELTA_ENCODING:    return this->delta()->valueBefore(value);
+            case SUCCINCT_ENCODING: return this->succinct()->valueBefore(value);
+            default:                return this->rle()->valueBefore(value);
+          }
+        }
+
+        inline pair_type valueAfter(usint value)
+        {
+          switch(this->encoding)
+          {
+            case NIBBLE_ENCODING:   return this->nibble()->valueAfter(value);
+            case DELTA_ENCODING:    return this->delta()->valueAfter(value);
+            case SUCCINCT_ENCODING: return this->succinct()->valueAfter(value);
+            default:                return this->rle()->valueAfter(value);
+          }
+        }
+
+        inline pair_type nextValue()
+        {
+          switch(this->encoding)
+          {
+            case NIBBLE_ENCODING:   return this->nibble()->nextValue();
+            case DELTA_ENCODING:    return this->delta()->nextValue();
+            case SUCCINCT_ENCODING: return this->succinct()->nextValue();
+            default:                return this->rle()->nextValue();
+          }
+        }
+
+        inline pair_type selectRun(usint index, usint max_length)
+        {
+          switch(this->encoding)
+          {
+            case NIBBLE_ENCODING:   return this->nibble()->selectRun(index, max_length);
+            case DELTA_ENCODING:    return this->delta()->selectRun(index, max_length);
+            case SUCCINCT_ENCODING: return this->succinct()->selectRun(index, max_length);
+            default:                return this->rle()->selectRun(index, max_length);
+          }
+        }
+
+        inline pair_type selectNextRun(usint max_length)
+        {
+          switch(this->encoding)
+          {
+            case NIBBLE_ENCODING:   return this->nibble()->selectNextRun(max_length);
+            case DELTA_ENCODING:    return this->delta()->selectNextRun(max_length);
+            case SUCCINCT_ENCODING: return this->succinct()->selectNextRun(max_length);
+            default:                return this->rle()->selectNextRun(max_length);
+          }
+        }
+
+        inline bool isSet(usint value)
+        {
+          switch(this->encoding)
+          {
+            case NIBBLE_ENCODING:   return this->nibble()->isSet(value);
+            case DELTA_ENCODING:    return this->delta()->isSet(value);
+            case SUCCINCT_ENCODING: return this->succinct()->isSet(value);
+            default:                return this->rle()->isSet(value);
+          }
+        }
+
+        usint countRuns();
+
+      private:
+        usint encoding;
+
+        // The actual iterator is constructed in place to avoid memory allocation.
+        union
+        {
+          char  rle_storage[sizeof(RLEVector::Iterator)];
+          char  nibble_storage[sizeof(NibbleVector::Iterator)];
+          char  delta_storage[sizeof(DeltaVector::Iterator)];
+          char  succinct_storage[sizeof(SuccinctVector::Iterator)];
+          usint alignment;
+        } storage;
+
+        inline RLEVector::Iterator* rle() const { return (RLEVector::Iterator*)(this->storage.rle_storage); }
+        inline NibbleVector::Iterator* nibble() const { return (NibbleVector::Iterator*)(this->storage.nibble_storage); }
+        inline DeltaVector::Iterator* delta() const { return (DeltaVector::Iterator*)(this->storage.delta_storage); }
+        inline SuccinctVector::Iterator* succinct() const { return (SuccinctVector::Iterator*)(this->storage.succinct_storage); }
+
+        // These are not allowed.
+        Iterator();
+        Iterator(const Iterator&);
+        Iterator& operator = (const Iterator&);
+    };
+
+//--------------------------------------------------------------------------
+
+  private:
+    usint      encoding;
+    BitVector* vector;
+
+    PsiVector(BitVector* _vector, usint _encoding);
+
+    // Returns the vector and deletes the wrapper.
+    static BitVector* release(PsiVector* wrapper);
+
+    // These are not allowed.
+    PsiVector();
+    PsiVector(const PsiVector&);
+    PsiVector& operator = (const PsiVector&);
+};
+
+
+} // namespace CSA
+
+
+#endif // PSIVECTOR_H
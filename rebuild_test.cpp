@@ -0,0 +1,189 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#include "rlcsa.h"
+#include "adaptive_samples.h"
+#include "misc/utils.h"
+
+
+using namespace CSA;
+
+
+/*
+  This program checks that files derived from an index are not used after the index has
+  been rebuilt from a different text of the same length. The text is indexed into
+  base_name.rebuild_test, and learned adaptive samples and dense samples are written for
+  it. The index is then rebuilt from the reversed text. The adaptive samples must
+  warm-start for the original index and start cold for the rebuilt one, and locate() must
+  return the same positions as an index built in memory without the dense samples. The
+  files are removed afterwards.
+*/
+
+
+RLCSA* buildIndex(const uchar* text, usint size, bool reverse, usint sample_rate, const std::string& base_name);
+usint checkAdaptive(const RLCSA& rlcsa, const std::string& base_name, usint queries, bool learn, bool& warm);
+void writeDenseSamples(const RLCSA& rlcsa, const std::string& base_name);
+usint checkLocate(const RLCSA& reference, const std::string& base_name, usint queries);
+void removeFiles(const std::string& base_name);
+
+
+int
+main(int argc, char** argv)
+{
+  std::cout << "Rebuild test" << std::endl;
+  if(argc < 2)
+  {
+    std::cout << "Usage: rebuild_test base_name [queries]" << std::endl;
+    return 1;
+  }
+
+  std::string base_name = argv[1];
+  usint queries = (argc > 2 ? atoi(argv[2]) : 10000);
+  std::string work_name = base_name + ".rebuild_test";
+  std::cout << "Base name: " << base_name << std::endl;
+  std::cout << "Queries: " << queries << std::endl;
+  std::cout << std::endl;
+
+  Parameters parameters;
+  parameters.set(SAMPLE_RATE);
+  parameters.read(base_name + PARAMETERS_EXTENSION);
+
+  std::ifstream input(base_name.c_str(), std::ios_base::binary);
+  if(!input)
+  {
+    std::cerr << "Error: Cannot open input file " << base_name << "!" << std::endl;
+    return 2;
+  }
+  usint size = fileSize(input);
+  uchar* text = new uchar[size];
+  input.read((char*)text, size);
+  input.close();
+
+  usint failures = 0;
+  bool warm = false;
+
+  // Learn the samples for the original index.
+  RLCSA* rlcsa = buildIndex(text, size, false, parameters.get(SAMPLE_RATE), work_name);
+  if(rlcsa == 0) { delete[] text; return 3; }
+  failures += checkAdaptive(*rlcsa, work_name, queries, true, warm);
+  failures += checkAdaptive(*rlcsa, work_name, queries, false, warm);
+  std::cout << "Original index: " << (warm ? "warm" : "cold") << " start" << std::endl;
+  if(!warm) { failures++; }
+  writeDenseSamples(*rlcsa, work_name);
+  failures += checkLocate(*rlcsa, work_name, queries);
+  delete rlcsa; rlcsa = 0;
+
+  // The learned and dense samples must not be used with the rebuilt index.
+  rlcsa = buildIndex(text, size, true, parameters.get(SAMPLE_RATE), work_name);
+  delete[] text; text = 0;
+  if(rlcsa == 0) { return 3; }
+  failures += checkAdaptive(*rlcsa, work_name, queries, false, warm);
+  std::cout << "Rebuilt index: " << (warm ? "warm" : "cold") << " start" << std::endl;
+  if(warm) { failures++; }
+  failures += checkLocate(*rlcsa, work_name, queries);
+  delete rlcsa; rlcsa = 0;
+
+  removeFiles(work_name);
+  std::cout << "Failures: " << failures << std::endl;
+  std::cout << std::endl;
+
+  return (failures > 0 ? 4 : 0);
+}
+
+
+// Indexes the text, possibly reversed before the final end marker, and writes the index.
+// The returned index has no dense samples.
+RLCSA*
+buildIndex(const uchar* text, usint size, bool reverse, usint sample_rate, const std::string& base_name)
+{
+  uchar* data = new uchar[size];
+  for(usint i = 0; i < size; i++) { data[i] = text[i]; }
+  if(reverse) { std::reverse(data, data + size - 1); }
+  RLCSA* rlcsa = new RLCSA(data, size, RLCSA_BLOCK_SIZE.second, sample_rate, 1, true);
+  if(!(rlcsa->isOk()) || !(rlcsa->supportsLocate())) { delete rlcsa; return 0; }
+  rlcsa->writeTo(base_name);
+  return rlcsa;
+}
+
+// Returns the number of positions where the adaptive samples and the index disagree.
+usint
+checkAdaptive(const RLCSA& rlcsa, const std::string& base_name, usint queries, bool learn, bool& warm)
+{
+  AdaptiveSamples samples(rlcsa, base_name);
+  if(!(samples.isOk())) { return 1; }
+  warm = samples.isWarmStart();
+
+  usint wrong = 0;
+  std::srand(0xDEADBEEF);
+  for(usint i = 0; i < queries; i++)
+  {
+    usint index = ((usint)std::rand() * RAND_MAX + std::rand()) % rlcsa.getSize();
+    if(samples.locate(index, false) != rlcsa.locate(index)) { wrong++; }
+  }
+  if(wrong > 0)
+  {
+    std::cerr << "Error: " << wrong << " wrong positions from the adaptive samples!" << std::endl;
+  }
+  if(learn) { samples.writeTo(base_name); }
+
+  return wrong;
+}
+
+// Samples every position in the first quarter of the text in the format of
+// build_dense_samples.
+void
+writeDenseSamples(const RLCSA& rlcsa, const std::string& base_name)
+{
+  std::vector<pair_type> samples;
+  for(usint pos = 0; pos < rlcsa.getTextSize() / 4; pos++)
+  {
+    samples.push_back(pair_type(rlcsa.inverseLocate(pos), pos));
+  }
+  sequentialSort(samples.begin(), samples.end());
+
+  std::string sample_name = base_name + DENSE_SAMPLES_EXTENSION;
+  std::ofstream sample_file(sample_name.c_str(), std::ios_base::binary);
+  usint identity = rlcsa.getIdentity(), text_size = rlcsa.getTextSize(), items = samples.size();
+  sample_file.write((char*)&identity, sizeof(identity));
+  sample_file.write((char*)&text_size, sizeof(text_size));
+  sample_file.write((char*)&items, sizeof(items));
+  sample_file.write((char*)&(samples[0]), items * sizeof(pair_type));
+  sample_file.close();
+}
+
+// Loads the index with the dense samples and returns the number of positions where it
+// disagrees with the reference.
+usint
+checkLocate(const RLCSA& reference, const std::string& base_name, usint queries)
+{
+  RLCSA rlcsa(base_name, false);
+  if(!(rlcsa.isOk()) || !(rlcsa.supportsLocate())) { return 1; }
+
+  usint wrong = 0;
+  std::srand(0xDEADBEEF);
+  for(usint i = 0; i < queries; i++)
+  {
+    usint index = ((usint)std::rand() * RAND_MAX + std::rand()) % rlcsa.getSize();
+    if(rlcsa.locate(index) != reference.locate(index)) { wrong++; }
+  }
+  if(wrong > 0)
+  {
+    std::cerr << "Error: " << wrong << " wrong positions with the dense samples!" << std::endl;
+  }
+
+  return wrong;
+}
+
+void
+removeFiles(const std::string& base_name)
+{
+  std::remove((base_name + ARRAY_EXTENSION).c_str());
+  std::remove((base_name + SA_SAMPLES_EXTENSION).c_str());
+  std::remove((base_name + PARAMETERS_EXTENSION).c_str());
+  std::remove((base_name + ADAPTIVE_SAMPLES_EXTENSION).c_str());
+  std::remove((base_name + DENSE_SAMPLES_EXTENSION).c_str());
+}
@@ -0,0 +1,197 @@
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#include "rlcsa.h"
+#include "misc/utils.h"
+
+#ifdef MULTITHREAD_SUPPORT
+#include <omp.h>
+#endif
+
+
+using namespace CSA;
+
+
+/*
+  This program replays a query log against a single-sequence index, uses the located
+  positions as weights for WeightedSampler, and replaces the samples of the index with
+  the resulting weighted samples. It reports the number of locate steps for the log
+  before and after the replacement.
+*/
+
+
+void
+printUsage()
+{
+  std::cout << "Usage: replay_samples [parameters] base_name queries" << std::endl;
+  std::cout << "  -b   Optimize for displaying the text after the occurrences instead of locate." << std::endl;
+  std::cout << "  -p   Query log is in Pizza & Chili format." << std::endl;
+  std::cout << "  -s#  Sample segments of # positions independently in parallel." << std::endl;
+  std::cout << "  -t#  Use # threads." << std::endl;
+  std::cout << "  -u#  Add # to the weight of every position (default 1)." << std::endl;
+  std::cout << std::endl;
+}
+
+// Replays the queries. Adds the weights of located positions if weights != 0.
+// Returns the total number of locate steps.
+usint
+replay(const RLCSA& rlcsa, const std::vector<std::string>& rows, weight_type* weights, usint& occurrences)
+{
+  usint total_steps = 0, total_occ = 0;
+
+  #pragma omp parallel for schedule(dynamic, 1) reduction(+:total_steps, total_occ)
+  for(usint i = 0; i < rows.size(); i++)
+  {
+    pair_type range = rlcsa.count(rows[i]);
+    if(isEmpty(range)) { continue; }
+
+    usint* steps = rlcsa.locate(range, true, true);
+    for(usint j = 0; j < length(range); j++) { total_steps += steps[j]; }
+    delete[] steps; steps = 0;
+    total_occ += length(range);
+
+    if(weights != 0)
+    {
+      usint* positions = rlcsa.locate(range, true, false);
+      for(usint j = 0; j < length(range); j++)
+      {
+        #pragma omp atomic
+        weights[positions[j]]++;
+      }
+      delete[] positions; positions = 0;
+    }
+  }
+
+  occurrences = total_occ;
+  return total_steps;
+}
+
+
+int
+main(int argc, char** argv)
+{
+  std::cout << "Query log replay for weighted samples" << std::endl;
+  std::cout << std::endl;
+
+  char* base_name = 0;
+  char* queries_name = 0;
+  bool backward = false, pizza = false;
+  usint threads = 1, uniform = 1, segment_length = 0;
+  for(int i = 1; i < argc; i++)
+  {
+    if(argv[i][0] == '-')
+    {
+      switch(argv[i][1])
+      {
+        case 'b':
+          backward = true; break;
+        case 'p':
+          pizza = true; break;
+        case 's':
+          segment_length = atoi(argv[i] + 2); break;
+        case 't':
+          threads = atoi(argv[i] + 2); break;
+        case 'u':
+          uniform = atoi(argv[i] + 2); break;
+        default:
+          std::cout << "Invalid option: " << argv[i] << std::endl << std::endl;
+          printUsage();
+          return 1;
+      }
+    }
+    else if(base_name == 0)
+    {
+      base_name = argv[i];
+    }
+    else if(queries_name == 0)
+    {
+      queries_name = argv[i];
+    }
+  }
+  if(queries_name == 0) { printUsage(); return 2; }
+  threads = std::max(threads, (usint)1);
+
+  std::cout << "Options:";
+  if(backward) { std::cout << " backward"; }
+  if(pizza) { std::cout << " pizza"; }
+  if(segment_length > 0) { std::cout << " segments=" << segment_length; }
+  std::cout << " threads=" << threads << " uniform=" << uniform << std::endl;
+  std::cout << "Base name: " << base_name << std::endl;
+  std::cout << "Queries: " << queries_name << std::endl;
+  std::cout << std::endl;
+
+  std::ifstream query_file(queries_name, std::ios_base::binary);
+  if(!query_file)
+  {
+    std::cerr << "Error opening query file!" << std::endl;
+    return 3;
+  }
+  std::vector<std::string> rows;
+  if(!pizza) { readRows(query_file, rows, true); }
+  else       { readPizzaChili(query_file, rows); }
+  query_file.close();
+
+  #ifdef MULTITHREAD_SUPPORT
+  omp_set_num_threads(threads);
+  #endif
+
+  Parameters parameters;
+  parameters.set(SAMPLE_RATE);
+  parameters.read(std::string(base_name) + PARAMETERS_EXTENSION);
+  usint sample_rate = parameters.get(SAMPLE_RATE);
+
+  double start = readTimer();
+  usint n = 0, occurrences = 0, old_steps = 0;
+  weight_type* weights = 0;
+  {
+    RLCSA rlcsa(base_name, false);
+    if(!rlcsa.isOk() || !rlcsa.supportsLocate()) { return 4; }
+    if(rlcsa.getNumberOfSequences() != 1)
+    {
+      std::cerr << "Error: Weighted samples support only one sequence!" << std::endl;
+      return 4;
+    }
+    n = rlcsa.getSize();
+    weights = new weight_type[n];
+    for(usint i = 0; i < n; i++) { weights[i] = uniform; }
+    old_steps = replay(rlcsa, rows, weights, occurrences);
+
+    Sampler* sampler = 0;
+    bool ok = false;
+    if(segment_length > 0)
+    {
+      SegmentedSampler* ssampler = new SegmentedSampler(weights, n, !backward);
+      ok = ssampler->buildSamples(sample_rate, segment_length, threads);
+      sampler = ssampler;
+    }
+    else
+    {
+      WeightedSampler* wsampler = new WeightedSampler(weights, n, !backward);
+      ok = wsampler->buildSamples(sample_rate, 0, threads);
+      sampler = wsampler;
+    }
+    weights = 0;
+    if(ok) { ok = sampler->writeSamples(rlcsa, base_name, threads); }
+    delete sampler; sampler = 0;
+    if(!ok) { return 5; }
+  }
+  double seconds = readTimer() - start;
+
+  RLCSA rlcsa(base_name, false);
+  if(!rlcsa.isOk()) { return 7; }
+  usint new_steps = replay(rlcsa, rows, 0, occurrences);
+
+  std::cout << "Queries:      " << rows.size() << std::endl;
+  std::cout << "Occurrences:  " << occurrences << std::endl;
+  if(occurrences > 0)
+  {
+    std::cout << "Locate steps: " << old_steps << " (" << (old_steps / (double)occurrences) << " / occurrence) before" << std::endl;
+    std::cout << "Locate steps: " << new_steps << " (" << (new_steps / (double)occurrences) << " / occurrence) after" << std::endl;
+  }
+  std::cout << "Time:         " << seconds << " seconds" << std::endl;
+  std::cout << std::endl;
+
+  return 0;
+}
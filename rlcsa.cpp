@@ -22,8 +22,8 @@ namespace CSA
 
 RLCSA::RLCSA(const std::string& base_name, bool print) :
   ok(false),
-  alphabet(0),
-  sa_samples(0), support_locate(false), support_display(false),
+  psi_encoding(PsiVector::DEFAULT_ENCODING), alphabet(0),
+  sa_samples(0), dense_samples(0), support_locate(false), support_display(false),
   end_points(0)
 {
   for(usint c = 0; c < CHARS; c++) { this->array[c] = 0; }
@@ -42,12 +42,29 @@ RLCSA::RLCSA(const std::string& base_name, bool print) :
 
   Parameters parameters;
   parameters.read(base_name + PARAMETERS_EXTENSION);
+  if(parameters.contains(PSI_ENCODING.first)) { this->psi_encoding = parameters.get(PSI_ENCODING); }
+  if(this->psi_encoding > PsiVector::HYBRID_ENCODING)
+  {
+    std::cerr << "RLCSA: Unknown Psi encoding " << this->psi_encoding << "!" << std::endl;
+    return;
+  }
   for(usint c = 0; c < CHARS; c++)
   {
-    if(this->alphabet->hasChar(c)) { this->array[c] = new PsiVector(array_file); }
+    if(!(this->alphabet->hasChar(c))) { continue; }
+    usint encoding = this->psi_encoding;
+    if(encoding == PsiVector::HYBRID_ENCODING)
+    {
+      array_file.read((char*)&encoding, sizeof(encoding));
+      if(encoding >= PsiVector::ENCODINGS)
+      {
+        std::cerr << "RLCSA: Unknown Psi encoding " << encoding << " for character " << c << "!" << std::endl;
+        return;
+      }
+    }
+    this->array[c] = new PsiVector(array_file, encoding);
   }
 
-  this->end_points = new DeltaVector(array_file);
+  this->end_points = new EndPointVector(array_file);
   this->number_of_sequences = this->end_points->getNumberOfItems();
 
   array_file.read((char*)&(this->sample_rate), sizeof(this->sample_rate));
@@ -68,6 +85,24 @@ RLCSA::RLCSA(const std::string& base_name, bool print) :
 
     this->support_locate = this->sa_samples->supportsLocate();
     this->support_display = this->sa_samples->supportsDisplay();
+
+    // Dense samples built for an earlier version of the index would return wrong positions.
+    std::string dense_sample_name = base_name + DENSE_SAMPLES_EXTENSION;
+    std::ifstream dense_sample_file(dense_sample_name.c_str(), std::ios_base::binary);
+    if(dense_sample_file)
+    {
+      usint identity = 0;
+      dense_sample_file.read((char*)&identity, sizeof(identity));
+      if(identity == this->getIdentity())
+      {
+        this->dense_samples = new SASamples(dense_sample_file, 1, true);
+      }
+      else
+      {
+        std::cerr << "RLCSA: Ignoring " << dense_sample_name << " built for a different index!" << std::endl;
+      }
+      dense_sample_file.close();
+    }
   }
 
   if(print) { parameters.print(); }
@@ -77,8 +112,8 @@ RLCSA::RLCSA(const std::string& base_name, bool print) :
 
 RLCSA::RLCSA(uchar* data, usint bytes, usint block_size, usint sa_sample_rate, usint threads, bool delete_data) :
   ok(false),
-  alphabet(0),
-  sa_samples(0), support_locate(false), support_display(false),
+  psi_encoding(PSI_ENCODING.second), alphabet(0),
+  sa_samples(0), dense_samples(0), support_locate(false), support_display(false),
   sample_rate(sa_sample_rate), end_points(0)
 {
   for(usint c = 0; c < CHARS; c++) { this->array[c] = 0; }
@@ -101,7 +136,8 @@ RLCSA::RLCSA(uchar* data, usint bytes, usint block_size, usint sa_sample_rate, u
 
 RLCSA::RLCSA(uchar* data, usint* ranks, usint bytes, usint block_size, usint sa_sample_rate, usint threads, bool delete_data) :
   ok(false),
-  sa_samples(0), support_locate(false), support_display(false),
+  psi_encoding(PSI_ENCODING.second),
+  sa_samples(0), dense_samples(0), support_locate(false), support_display(false),
   sample_rate(sa_sample_rate), end_points(0)
 {
   for(usint c = 0; c < CHARS; c++) { this->array[c] = 0; }
@@ -124,8 +160,8 @@ RLCSA::RLCSA(uchar* data, usint* ranks, usint bytes, usint block_size, usint sa_
 
 RLCSA::RLCSA(uchar* data, usint bytes, usint block_size, usint sa_sample_rate, usint threads, Sampler* sampler, bool delete_data) :
   ok(false),
-  alphabet(0),
-  sa_samples(0), support_locate(false), support_display(false),
+  psi_encoding(PSI_ENCODING.second), alphabet(0),
+  sa_samples(0), dense_samples(0), support_locate(false), support_display(false),
   sample_rate(sa_sample_rate),
   end_points(0)
 {
@@ -155,8 +191,8 @@ RLCSA::RLCSA(uchar* data, usint bytes, usint block_size, usint sa_sample_rate, u
 
 RLCSA::RLCSA(RLCSA& index, RLCSA& increment, usint* positions, usint block_size, usint threads) :
   ok(false),
-  alphabet(0),
-  sa_samples(0), support_locate(false), support_display(false),
+  psi_encoding(index.psi_encoding), alphabet(0),
+  sa_samples(0), dense_samples(0), support_locate(false), support_display(false),
   end_points(0)
 {
   for(usint c = 0; c < CHARS; c++) { this->array[c] = 0; }
@@ -176,6 +212,10 @@ RLCSA::RLCSA(RLCSA& index, RLCSA& increment, usint* positions, usint block_size,
     return;
   }
 
+  if(index.dense_samples != 0 || increment.dense_samples != 0)
+  {
+    std::cerr << "RLCSA: Dense samples are not merged; rebuild them with build_dense_samples!" << std::endl;
+  }
   index.strip();
   increment.strip();
 
@@ -204,7 +244,7 @@ RLCSA::RLCSA(RLCSA& index, RLCSA& increment, usint* positions, usint block_size,
     else if(c == -1) { this->mergeSamples(index, increment, positions);  }
     else if(this->alphabet->hasChar(c) != 0)
     {
-      this->array[c] = mergeVectors<PsiVector, PsiVector::Encoder, PsiVector::Iterator>(index.array[c], increment.array[c], positions, increment.data_size + increment.number_of_sequences, psi_size, block_size);
+      this->array[c] = PsiVector::merge(index.array[c], increment.array[c], positions, increment.data_size + increment.number_of_sequences, psi_size, block_size, this->psi_encoding);
       index.array[c] = 0;
       increment.array[c] = 0;
 
@@ -224,6 +264,7 @@ RLCSA::~RLCSA()
   for(usint c = 0; c < CHARS; c++) { delete this->array[c]; this->array[c] = 0; }
   delete this->alphabet; this->alphabet = 0;
   delete this->sa_samples; this->sa_samples = 0;
+  delete this->dense_samples; this->dense_samples = 0;
   delete this->end_points; this->end_points = 0;
 }
 
@@ -245,6 +286,11 @@ RLCSA::writeTo(const std::string& base_name) const
   {
     if(this->array[c] != 0)
     {
+      if(this->psi_encoding == PsiVector::HYBRID_ENCODING)
+      {
+        usint encoding = this->array[c]->getEncoding();
+        array_file.write((char*)&encoding, sizeof(encoding));
+      }
       this->array[c]->writeTo(array_file);
     }
   }
@@ -277,6 +323,7 @@ RLCSA::writeTo(const std::string& base_name) const
     parameters.set(WEIGHTED_SAMPLES.first, 1);
   }
   else { parameters.set(WEIGHTED_SAMPLES); }
+  parameters.set(PSI_ENCODING.first, this->getPsiEncoding());
   parameters.write(base_name + PARAMETERS_EXTENSION);
 }
 
@@ -304,6 +351,71 @@ RLCSA::count(const std::string& pattern) const
   return index_range;
 }
 
+std::vector<pair_type>*
+RLCSA::approximateCount(const std::string& pattern, usint errors, bool edits) const
+{
+  std::vector<pair_type>* results = new std::vector<pair_type>;
+
+  std::vector<usint> chars;
+  for(usint c = 0; c < CHARS; c++)
+  {
+    if(this->array[c] != 0) { chars.push_back(c); }
+  }
+
+  // The BWT range of the empty pattern includes the end markers.
+  pair_type root(0, this->number_of_sequences + this->data_size - 1);
+  this->approximateCount(pattern, pattern.length(), root, errors, edits, chars, *results);
+
+  // Convert to SA ranges. Only the empty string matches the end markers.
+  for(std::vector<pair_type>::iterator iter = results->begin(); iter != results->end(); ++iter)
+  {
+    iter->first = std::max(iter->first, this->number_of_sequences);
+    this->convertToSARange(*iter);
+  }
+
+  // SA ranges are either disjoint or nested. When sorted by start, longest first, it is
+  // enough to drop the ranges contained in the previous one.
+  for(std::vector<pair_type>::iterator iter = results->begin(); iter != results->end(); ++iter)
+  {
+    iter->second = ~(iter->second);
+  }
+  sequentialSort(results->begin(), results->end());
+  usint tail = 0;
+  for(usint i = 0; i < results->size(); i++)
+  {
+    pair_type range((*results)[i].first, ~((*results)[i].second));
+    if(tail > 0 && range.second <= (*results)[tail - 1].second) { continue; }
+    (*results)[tail] = range; tail++;
+  }
+  results->resize(tail);
+
+  return results;
+}
+
+void
+RLCSA::approximateCount(const std::string& pattern, usint i, pair_type range, usint errors, bool edits,
+  const std::vector<usint>& chars, std::vector<pair_type>& results) const
+{
+  if(i == 0) { results.push_back(range); return; }
+
+  usint target = (uchar)pattern[i - 1];
+  for(std::vector<usint>::const_iterator iter = chars.begin(); iter != chars.end(); ++iter)
+  {
+    pair_type next = this->LF(range, *iter);
+    if(isEmpty(next)) { continue; }
+
+    // Match or mismatch.
+    if(*iter == target) { this->approximateCount(pattern, i - 1, next, errors, edits, chars, results); }
+    else if(errors > 0) { this->approximateCount(pattern, i - 1, next, errors - 1, edits, chars, results); }
+
+    // Deletion: the text has an extra character.
+    if(edits && errors > 0) { this->approximateCount(pattern, i, next, errors - 1, edits, chars, results); }
+  }
+
+  // Insertion: the pattern has an extra character.
+  if(edits && errors > 0) { this->approximateCount(pattern, i - 1, range, errors - 1, edits, chars, results); }
+}
+
 //--------------------------------------------------------------------------
 
 void
@@ -375,8 +487,7 @@ RLCSA::locate(usint index, bool steps) const
 usint
 RLCSA::inverseLocate(usint location) const
 {
-  if(!(this->support_locate)) { return this->data_size; }
-  // TODO: Check for out-of-bounds locations somehow.
+  if(!(this->support_locate) || location >= this->getTextSize()) { return this->data_size; }
 
   // Inverse-locate the given location in BWT space, and convert back to SA
   // space before returning.
@@ -422,6 +533,10 @@ RLCSA::directLocate(usint index, bool steps) const
       // original sequences.
       return (steps ? offset : this->sa_samples->getSampleAt(index) - offset);
     }
+    if(this->dense_samples != 0 && this->dense_samples->isSampled(index))
+    {
+      return (steps ? offset : this->dense_samples->getSampleAt(index) - offset);
+    }
     
     // If we get here, we couldn't map this position. Proceed forwards (towards
     // the end of the sequence), in hopes of hitting either a sample or the
@@ -437,9 +552,14 @@ RLCSA::directInverseLocate(usint location) const
 {
   // Get the SA value and SA index (in that order) of the last SA sample
   // before the given text location.
-  pair_type last_sample = this->sa_samples->inverseSA(location);
+  pair_type last_sample = this->getLastSampleBefore(location);
   
-  // TODO: catch the (size, size) sentinel.
+  // There is no sample at or before the location, or the location is out of bounds.
+  if(last_sample.first > location || last_sample.second >= this->data_size)
+  {
+    return this->data_size + this->number_of_sequences;
+  }
+
   while(last_sample.first < location) {
     // We're not at the desired text location, so we must be before it.
     
@@ -454,12 +574,6 @@ RLCSA::directInverseLocate(usint location) const
       
   }
   
-  if(last_sample.first != location) {
-    // We managed to start on the wrong side of what we're trying to locate;
-    // inverseSA lied to us.
-    throw "Somehow skipped desired inverse locate position";
-  }
-  
   // Return the answer (SA index) in BWT coordinates. It will probably be
   // immediately converted back to SA coordinates, but it's worth it for
   // consistency with the directLocate function, which takes in BWT coordinates.
@@ -532,7 +646,7 @@ RLCSA::processRun(pair_type run, usint* data, usint* offsets, bool* finished, Ps
     }
     if(data[i] < this->number_of_sequences) // Implicit sample here.
     {
-      DeltaVector::Iterator iter(*(this->end_points));
+      EndPointVector::Iterator iter(*(this->end_points));
       data[i] = (steps ? offsets[i] : iter.select(data[i]) + 1 - offsets[i]);
       finished[i] = true;
       if(run_left > 0) { run_left--; }
@@ -540,7 +654,7 @@ RLCSA::processRun(pair_type run, usint* data, usint* offsets, bool* finished, Ps
     }
     if(next_sample.first < data[i]) // Need another sample.
     {
-      next_sample = this->sa_samples->getFirstSampleAfter(data[i] - this->number_of_sequences);
+      next_sample = this->getFirstSampleAfter(data[i] - this->number_of_sequences);
       next_sample.first += this->number_of_sequences;
     }
     if(data[i] < next_sample.first) // No sample found for current position.
@@ -562,7 +676,7 @@ RLCSA::processRun(pair_type run, usint* data, usint* offsets, bool* finished, Ps
     }
     else  // Sampled position found.
     {
-      data[i] = (steps ? offsets[i] : this->sa_samples->getSample(next_sample.second) - offsets[i]);
+      data[i] = (steps ? offsets[i] : next_sample.second - offsets[i]);
       finished[i] = true;
       if(run_left > 0) { run_left--; }
     }
@@ -572,6 +686,34 @@ RLCSA::processRun(pair_type run, usint* data, usint* offsets, bool* finished, Ps
 
 //--------------------------------------------------------------------------
 
+pair_type
+RLCSA::getFirstSampleAfter(usint index) const
+{
+  pair_type result = this->sa_samples->getFirstSampleAfter(index);
+  if(result.first < this->data_size) { result.second = this->sa_samples->getSample(result.second); }
+  if(this->dense_samples != 0)
+  {
+    pair_type dense = this->dense_samples->getFirstSampleAfter(index);
+    if(dense.first < result.first) { result = pair_type(dense.first, this->dense_samples->getSample(dense.second)); }
+  }
+  return result;
+}
+
+pair_type
+RLCSA::getLastSampleBefore(usint value) const
+{
+  pair_type result = this->sa_samples->inverseSA(value);
+  if(this->dense_samples != 0)
+  {
+    // The dense sample is never in an earlier sequence than the regular one.
+    pair_type dense = this->dense_samples->inverseSA(value);
+    if(dense.first <= value && dense.first > result.first) { result = dense; }
+  }
+  return result;
+}
+
+//--------------------------------------------------------------------------
+
 uchar*
 RLCSA::display(usint sequence, bool include_end_marker) const
 {
@@ -671,7 +813,7 @@ RLCSA::displayFromPosition(usint index, usint max_len, uchar* data) const
 void
 RLCSA::displayUnsafe(pair_type range, uchar* data, bool get_ranks, usint* ranks) const
 {
-  pair_type res = this->sa_samples->inverseSA(range.first);
+  pair_type res = this->getLastSampleBefore(range.first);
   usint i = res.first, pos = res.second;
 
   if(length(range) >= 1024)
@@ -811,7 +953,7 @@ RLCSA::getSequenceRange(usint number) const
   if(number >= this->number_of_sequences) { return EMPTY_PAIR; }
 
   pair_type result;
-  DeltaVector::Iterator iter(*(this->end_points));
+  EndPointVector::Iterator iter(*(this->end_points));
   if(number == 0)
   {
     result.first = 0;
@@ -830,7 +972,7 @@ usint
 RLCSA::getSequenceForPosition(usint value) const
 {
   if(value == 0) { return 0; }
-  DeltaVector::Iterator iter(*(this->end_points));
+  EndPointVector::Iterator iter(*(this->end_points));
   return iter.rank(value - 1);
 }
 
@@ -845,7 +987,7 @@ RLCSA::getSequenceForPosition(usint* values, usint len) const
 {
   if(values == 0) { return 0; }
 
-  DeltaVector::Iterator iter(*(this->end_points));
+  EndPointVector::Iterator iter(*(this->end_points));
   for(usint i = 0; i < len; i++)
   {
     if(values[i] > 0) { values[i] = iter.rank(values[i] - 1); }
@@ -858,7 +1000,7 @@ pair_type
 RLCSA::getRelativePosition(usint value) const
 {
   // Get an iterator so we can use the vector of sequence endpoints.
-  DeltaVector::Iterator iter(*(this->end_points));
+  EndPointVector::Iterator iter(*(this->end_points));
   
   // Start out saying we're in text 0 at index whatever our index in the whole
   // string of texts is.
@@ -884,7 +1026,7 @@ usint
 RLCSA::getAbsolutePosition(pair_type position) const
 {
   // Get an iterator so we can use the vector of sequence endpoints.
-  DeltaVector::Iterator iter(*(this->end_points));
+  EndPointVector::Iterator iter(*(this->end_points));
   
   // Where is this position as an absolute position? Start off at the beginning.
   usint value = 0;
@@ -954,6 +1096,30 @@ RLCSA::countRuns() const
   return runs;
 }
 
+usint
+RLCSA::getIdentity() const
+{
+  // FNV-1a over words.
+  usint identity = 2166136261u;
+  const usint prime = 16777619;
+  identity = (identity ^ this->data_size) * prime;
+  identity = (identity ^ this->number_of_sequences) * prime;
+  identity = (identity ^ this->sample_rate) * prime;
+  for(usint c = 0; c < CHARS; c++)
+  {
+    identity = (identity ^ this->alphabet->countOf(c)) * prime;
+  }
+  if(this->support_locate)
+  {
+    for(usint i = 0; i < this->sa_samples->getNumberOfSamples(); i++)
+    {
+      identity = (identity ^ this->sa_samples->getSample(i)) * prime;
+    }
+  }
+
+  return identity;
+}
+
 //--------------------------------------------------------------------------
 
 SuffixArray*
@@ -996,6 +1162,34 @@ RLCSA::deleteIterators(PsiVector::Iterator** iters) const
 
 //--------------------------------------------------------------------------
 
+void
+RLCSA::setDirectInverseSamples(bool direct)
+{
+  if(this->sa_samples != 0) { this->sa_samples->setDirectInverse(direct); }
+}
+
+void
+RLCSA::setPsiEncoding(usint encoding, usint threads)
+{
+  if(!(this->isOk()) || encoding > PsiVector::HYBRID_ENCODING) { return; }
+
+  usint block_size = this->getBlockSize() * sizeof(usint);
+  #ifdef MULTITHREAD_SUPPORT
+  omp_set_num_threads(threads);
+  #endif
+  #pragma omp parallel for schedule(dynamic, 1)
+  for(usint c = 0; c < CHARS; c++)
+  {
+    if(this->array[c] == 0) { continue; }
+    usint target = encoding;
+    if(target == PsiVector::HYBRID_ENCODING) { target = PsiVector::chooseEncoding(*(this->array[c])); }
+    if(this->array[c]->getEncoding() == target) { continue; }
+    PsiVector* temp = new PsiVector(*(this->array[c]), target, block_size);
+    delete this->array[c]; this->array[c] = temp;
+  }
+  this->psi_encoding = encoding;
+}
+
 usint
 RLCSA::reportSize(bool print) const
 {
@@ -1022,6 +1216,12 @@ RLCSA::reportSize(bool print) const
     if(print) { std::cout << "SA samples:      " << (temp / (double)MEGABYTE) << " MB" << std::endl; }
     bytes += temp;
   }
+  if(this->dense_samples != 0)
+  {
+    temp = this->dense_samples->reportSize();
+    if(print) { std::cout << "Dense samples:   " << (temp / (double)MEGABYTE) << " MB" << std::endl; }
+    bytes += temp;
+  }
 
   if(print)
   {
@@ -1040,11 +1240,32 @@ RLCSA::printInfo() const
   std::cout << "Sequences:       " << this->number_of_sequences << std::endl;
   std::cout << "Original size:   " << megabytes << " MB" << std::endl;
   std::cout << "Block size:      " << (this->getBlockSize() * sizeof(usint)) << " bytes" << std::endl;
+  std::cout << "Psi encoding:    " << PsiVector::encodingName(this->getPsiEncoding());
+  if(this->getPsiEncoding() == PsiVector::HYBRID_ENCODING)
+  {
+    usint counts[PsiVector::ENCODINGS] = { 0 };
+    for(usint c = 0; c < CHARS; c++)
+    {
+      if(this->array[c] != 0) { counts[this->array[c]->getEncoding()]++; }
+    }
+    std::cout << " (";
+    for(usint i = 0; i < PsiVector::ENCODINGS; i++)
+    {
+      if(i > 0) { std::cout << ", "; }
+      std::cout << PsiVector::encodingName(i) << " " << counts[i];
+    }
+    std::cout << ")";
+  }
+  std::cout << std::endl;
   if(this->support_locate || this->support_display)
   {
     std::cout << "Sample rate:     " << this->sample_rate;
     if(this->sa_samples->isWeighted()) { std::cout << " (weighted)"; }
     std::cout << std::endl;
+    if(this->dense_samples != 0)
+    {
+      std::cout << "Dense samples:   " << this->dense_samples->getNumberOfSamples() << std::endl;
+    }
   }
   std::cout << std::endl;
 }
@@ -1498,10 +1719,10 @@ RLCSA::lcpDirect(usint index) const
 void
 RLCSA::mergeEndPoints(RLCSA& index, RLCSA& increment)
 {
-  DeltaEncoder* endings = new DeltaEncoder(RLCSA::ENDPOINT_BLOCK_SIZE);
+  EndPointVector::Encoder* endings = new EndPointVector::Encoder(RLCSA::ENDPOINT_BLOCK_SIZE);
 
-  DeltaVector::Iterator index_iter(*(index.end_points));
-  DeltaVector::Iterator increment_iter(*(increment.end_points));
+  EndPointVector::Iterator index_iter(*(index.end_points));
+  EndPointVector::Iterator increment_iter(*(increment.end_points));
 
   endings->setBit(index_iter.select(0));
   for(usint i = 1; i < index.number_of_sequences; i++)
@@ -1519,7 +1740,7 @@ RLCSA::mergeEndPoints(RLCSA& index, RLCSA& increment)
   sum += increment.end_points->getSize();
   delete increment.end_points; increment.end_points = 0;
 
-  this->end_points = new DeltaVector(*endings, sum);
+  this->end_points = new EndPointVector(*endings, sum);
   delete endings;
 }
 
@@ -1569,7 +1790,7 @@ RLCSA::buildRLCSA(uchar* data, usint* ranks, usint bytes, usint block_size, usin
 
 
   // Determine the number of sequences and mark their end points.
-  DeltaEncoder endings(RLCSA::ENDPOINT_BLOCK_SIZE);
+  EndPointVector::Encoder endings(RLCSA::ENDPOINT_BLOCK_SIZE);
   if(multiple_sequences)
   {
     this->number_of_sequences = 0;
@@ -1596,14 +1817,14 @@ RLCSA::buildRLCSA(uchar* data, usint* ranks, usint bytes, usint block_size, usin
       if(delete_data) { delete[] data; }
       return;
     }
-    this->end_points = new DeltaVector(endings, chars_encountered + padding);
+    this->end_points = new EndPointVector(endings, chars_encountered + padding);
   }
   else
   {
     this->number_of_sequences = 1;
-    DeltaEncoder endings(RLCSA::ENDPOINT_BLOCK_SIZE, RLCSA::ENDPOINT_BLOCK_SIZE);
+    EndPointVector::Encoder endings(RLCSA::ENDPOINT_BLOCK_SIZE, RLCSA::ENDPOINT_BLOCK_SIZE);
     endings.setBit(bytes - 1);
-    this->end_points = new DeltaVector(endings, bytes);
+    this->end_points = new EndPointVector(endings, bytes);
   }
 
 
@@ -1657,7 +1878,14 @@ RLCSA::buildRLCSA(uchar* data, usint* ranks, usint bytes, usint block_size, usin
 
     short_pair* curr = sa + this->alphabet->cumulative(c) + this->number_of_sequences;
     short_pair* limit = curr + this->alphabet->countOf(c);
-    PsiVector::Encoder encoder(block_size);
+    usint encoding = this->psi_encoding;
+    if(encoding == PsiVector::HYBRID_ENCODING)
+    {
+      PsiVector::Statistics statistics(this->data_size + this->number_of_sequences);
+      for(short_pair* temp = curr; temp < limit; ++temp) { statistics.addRun((*temp).first, 1); }
+      encoding = statistics.bestEncoding();
+    }
+    PsiVector::Encoder encoder(block_size, encoding);
     pair_type run((*curr).first, 1); ++curr;
 
     for(; curr < limit; ++curr)
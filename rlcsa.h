@@ -9,6 +9,7 @@
 #include "bits/nibblevector.h"
 #include "bits/succinctvector.h"
 
+#include "psivector.h"
 #include "sasamples.h"
 #include "alphabet.h"
 #include "lcpsamples.h"
@@ -24,6 +25,7 @@ namespace CSA
 const std::string PSI_EXTENSION = ".psi";
 const std::string ARRAY_EXTENSION = ".rlcsa.array";
 const std::string SA_SAMPLES_EXTENSION = ".rlcsa.sa_samples";
+const std::string DENSE_SAMPLES_EXTENSION = ".rlcsa.dense_samples";
 const std::string PARAMETERS_EXTENSION = ".rlcsa.parameters";
 const std::string DOCUMENT_EXTENSION = ".rlcsa.docs";
 const std::string LCP_SAMPLES_EXTENSION = ".lcp_samples";
@@ -35,12 +37,10 @@ const parameter_type SAMPLE_RATE       = parameter_type("SAMPLE_RATE", 128);
 const parameter_type SUPPORT_LOCATE    = parameter_type("SUPPORT_LOCATE", 1);
 const parameter_type SUPPORT_DISPLAY   = parameter_type("SUPPORT_DISPLAY", 1);
 const parameter_type WEIGHTED_SAMPLES  = parameter_type("WEIGHTED_SAMPLES", 0);
-
-
-#ifdef USE_NIBBLE_VECTORS
-typedef NibbleVector  PsiVector;
+#ifdef HYBRID_PSI_VECTORS
+const parameter_type PSI_ENCODING      = parameter_type("PSI_ENCODING", PsiVector::HYBRID_ENCODING);
 #else
-typedef RLEVector     PsiVector;
+const parameter_type PSI_ENCODING      = parameter_type("PSI_ENCODING", PsiVector::DEFAULT_ENCODING);
 #endif
 
 #ifdef SUCCINCT_LCP_VECTOR
@@ -100,6 +100,12 @@ class RLCSA
     // Returns the closed range containing the matches.
     pair_type count(const std::string& pattern) const;
 
+    // Returns the closed ranges of suffixes starting with a string within the given number of
+    // mismatches (or edit operations, if edits is true) from the pattern, in sorted order.
+    // Duplicate and nested ranges are merged. Insertions before the first character of the
+    // pattern are not considered. User must free the returned vector.
+    std::vector<pair_type>* approximateCount(const std::string& pattern, usint errors, bool edits = false) const;
+
     // Used when merging CSAs.
     void reportPositions(uchar* data, usint length, usint* positions) const;
 
@@ -112,7 +118,7 @@ class RLCSA
     // Returns SA[index].
     usint locate(usint index, bool steps = false) const;
     
-    // Given SA[index], returns index.
+    // Given SA[index], returns index. Returns getSize() if location is not a valid text position.
     usint inverseLocate(usint location) const;
 
     // Returns T^{sequence}[range]. User must free the buffer.
@@ -158,6 +164,10 @@ class RLCSA
     // Returns the number of equal letter runs in the BWT. Runs consisting of end markers are ignored.
     usint countRuns() const;
 
+    // A checksum of the sizes, the sample rate, the character counts, and the SA samples.
+    // Files derived from the index store it to detect that the index has been rebuilt.
+    usint getIdentity() const;
+
     // Return the suffix array for a particular sequence. User must free the suffix array.
     SuffixArray* getSuffixArrayForSequence(usint number) const;
 
@@ -218,7 +228,7 @@ class RLCSA
 
     inline usint getImplicitSample(usint bwt_index) const
     {
-      DeltaVector::Iterator iter(*(this->end_points));
+      EndPointVector::Iterator iter(*(this->end_points));
       return iter.select(bwt_index) + 1;
     }
 
@@ -253,10 +263,19 @@ class RLCSA
 
     inline bool supportsLocate() const { return this->support_locate; }
     inline bool supportsDisplay() const { return this->support_display; }
+
+    // Chooses the layout of regular inverse SA samples used by display and inverseLocate.
+    // The direct layout (default) is faster, while the other one is slightly smaller.
+    void setDirectInverseSamples(bool direct);
     inline usint getSize() const { return this->data_size; }
     inline usint getTextSize() const { return this->end_points->getSize(); }
     inline usint getNumberOfSequences() const { return this->number_of_sequences; }
     inline usint getBlockSize() const { return this->array[this->alphabet->getFirstChar()]->getBlockSize(); }
+    inline usint getPsiEncoding() const { return this->psi_encoding; }
+
+    // Re-encodes the Psi vectors using the given encoding (see PsiVector). With
+    // HYBRID_ENCODING, the encoding is chosen separately for each character.
+    void setPsiEncoding(usint encoding, usint threads = 1);
 
     // Returns the size of the data structure.
     usint reportSize(bool print = false) const;
@@ -296,15 +315,17 @@ class RLCSA
     usint data_size;
 
     PsiVector* array[CHARS];
+    usint      psi_encoding;  // PsiVector encoding or HYBRID_ENCODING.
     Alphabet*  alphabet;
     SASamples* sa_samples;
+    SASamples* dense_samples; // Optional weighted samples over selected regions.
 
     bool  support_locate, support_display;
 
     // A sequence starts at the next multiple of sample_rate after the end of previous sequence.
     usint sample_rate;
     usint number_of_sequences;
-    DeltaVector* end_points;
+    EndPointVector* end_points;
 
 //--------------------------------------------------------------------------
 //  INTERNAL VERSIONS OF QUERIES
@@ -323,6 +344,16 @@ class RLCSA
     void  displayUnsafe(pair_type range, uchar* data, bool get_ranks = false, usint* ranks = 0) const;
 
     void locateRange(pair_type range, std::vector<usint>& vec) const;
+
+    // Look up the regular samples first and then the dense samples.
+    // Returns (SA index, SA value) of the first sample at or after SA index, or (>= data_size, ???).
+    pair_type getFirstSampleAfter(usint index) const;
+    // Returns (SA value, SA index) of the last sample at or before SA value.
+    pair_type getLastSampleBefore(usint value) const;
+
+    // Backtracking for approximateCount(). Matches pattern[0, i - 1] backward from the BWT range.
+    void approximateCount(const std::string& pattern, usint i, pair_type range, usint errors, bool edits,
+      const std::vector<usint>& chars, std::vector<pair_type>& results) const;
     
     // Given a sequence position, return the corresponding BWT position.
     usint directInverseLocate(usint location) const;
@@ -5,8 +5,11 @@
 
 #include "rlcsa.h"
 #include "adaptive_samples.h"
+#include "runsamples.h"
 #include "suffixarray.h"
 #include "docarray.h"
+#include "doccounts.h"
+#include "bits/wordallocator.h"
 
 #ifdef MULTITHREAD_SUPPORT
 #include <omp.h>
@@ -76,11 +79,11 @@ int main(int argc, char** argv)
   std::cout << std::endl;
 
   bool adaptive = false, direct = false, locate = false, pizza = false, count_steps = false;
-  bool use_sa = false;
-  bool listing = false, rle = false;
-  usint ignore = 0, generate = 0;
+  bool use_sa = false, use_runs = false;
+  bool listing = false, rle = false, parallel_listing = false;
+  usint ignore = 0, generate = 0, top_k = 0, memory_policy = WordAllocator::getPolicy();
   bool ignore_tab = false;
-  bool write = false, write_patterns = false, sort_patterns = false;
+  bool write = false, write_patterns = false, sort_patterns = false, write_adaptive = false;
   char* base_name = 0;
   char* patterns_name = 0;
   #ifdef MULTITHREAD_SUPPORT
@@ -94,6 +97,8 @@ int main(int argc, char** argv)
       {
         case 'a':
           adaptive = true; break;
+        case 'A':
+          write_adaptive = true; break;
         case 'd':
           direct = true; break;
         case 'g':
@@ -104,12 +109,20 @@ int main(int argc, char** argv)
           break;
         case 'l':
           locate = true; break;
+        case 'k':
+          top_k = atoi(argv[i] + 2); break;
         case 'L':
           listing = true; break;
+        case 'm':
+          memory_policy = atoi(argv[i] + 2); break;
         case 'o':
           sort_patterns = true; break;
+        case 'P':
+          parallel_listing = true; break;
         case 'p':
           pizza = true; break;
+        case 'R':
+          use_runs = true; break;
         case 'r':
           rle = true; break;
         case 'S':
@@ -147,39 +160,50 @@ int main(int argc, char** argv)
   if(generate > 0) { std::cout << " generate=" << generate; }
   if(ignore_tab) { std::cout << " ignore=tab"; }
   else if(ignore > 0) { std::cout << " ignore=" << ignore; }
-  if(use_sa) { adaptive = direct = count_steps = listing = false; }
-  if(listing)
+  if(use_sa) { adaptive = direct = count_steps = listing = use_runs = false; top_k = 0; }
+  if(top_k > 0)
+  {
+    locate = listing = adaptive = direct = count_steps = write = use_runs = false;
+    rle = parallel_listing = false;
+    std::cout << " top-k=" << top_k;
+  }
+  else if(listing)
   {
-    locate = adaptive = count_steps = write = false;
+    locate = adaptive = count_steps = write = use_runs = false;
     std::cout << " listing";
-    if(direct || rle)
+    if(direct || rle || parallel_listing)
     {
       std::cout << "(";
       if(direct)      { std::cout << " direct"; }
       if(rle)         { std::cout << " rle"; }
+      if(parallel_listing) { std::cout << " parallel"; }
       if(count_steps) { std::cout << " steps"; write = false; }
       std::cout << " )";
     }
   }
   else if(locate)
   {
-    rle = sort_patterns = false;
+    rle = sort_patterns = parallel_listing = false;
     std::cout << " locate";
-    if(adaptive || direct || count_steps)
+    if(use_runs) { adaptive = direct = false; }
+    if(adaptive || direct || count_steps || use_runs)
     {
       std::cout << "(";
+      if(use_runs)    { std::cout << " runs"; }
       if(adaptive)    { std::cout << " adaptive"; direct = true; }
+      if(adaptive && write_adaptive) { std::cout << " write_adaptive"; }
       if(direct)      { std::cout << " direct"; }
       if(count_steps) { std::cout << " steps"; write = false; }
       std::cout << " )";
     }
   }
-  else { adaptive = direct = count_steps = write = rle = sort_patterns = false; }
+  else { adaptive = direct = count_steps = write = rle = sort_patterns = use_runs = parallel_listing = false; }
   if(sort_patterns) { std::cout << " sort_patterns"; }
   if(pizza) { std::cout << " pizza"; }
   if(use_sa) { std::cout << " sa"; }
   if(write_patterns) { std::cout << " write_patterns"; }
   if(write) { std::cout << " write"; }
+  if(memory_policy != WordAllocator::HEAP) { std::cout << " memory=" << memory_policy; }
   std::cout << std::endl;
   std::cout << "Base name: " << base_name << std::endl;
   if(patterns_name != 0) { std::cout << "Patterns: " << patterns_name << std::endl; }
@@ -189,6 +213,7 @@ int main(int argc, char** argv)
   std::cout << std::endl;
 
 
+  WordAllocator::setPolicy(memory_policy);
   const RLCSA* rlcsa = (use_sa ? 0 : new RLCSA(base_name, false));
   const SuffixArray* sa = (use_sa ? new SuffixArray(base_name, false) : 0);
   usint size = 0, text_size = 0;
@@ -214,6 +239,10 @@ int main(int argc, char** argv)
     }
     rlcsa->printInfo();
     rlcsa->reportSize(true);
+    if(WordAllocator::mappedBytes() > 0)
+    {
+      std::cout << "Mapped memory:   " << (WordAllocator::mappedBytes() / (double)MEGABYTE) << " MB" << std::endl << std::endl;
+    }
     size = rlcsa->getSize();
     text_size = rlcsa->getTextSize();
   }
@@ -227,7 +256,7 @@ int main(int argc, char** argv)
   AdaptiveSamples* adaptive_samples = 0;
   if(adaptive)
   {
-    adaptive_samples = new AdaptiveSamples(*rlcsa, base_name);
+    adaptive_samples = new AdaptiveSamples(*rlcsa, base_name, threads);
     adaptive_samples->report();
     if(!adaptive_samples->isOk())
     {
@@ -238,6 +267,21 @@ int main(int argc, char** argv)
     }
   }
 
+  RunSamples* run_samples = 0;
+  if(use_runs)
+  {
+    run_samples = new RunSamples(*rlcsa, base_name);
+    run_samples->reportSize(true);
+    if(!run_samples->isOk())
+    {
+      delete rlcsa; rlcsa = 0;
+      delete sa; sa = 0;
+      delete adaptive_samples; adaptive_samples = 0;
+      delete run_samples; run_samples = 0;
+      return 4;
+    }
+  }
+
   DocArray* docarray = 0;
   if(listing)
   {
@@ -260,6 +304,21 @@ int main(int argc, char** argv)
     }
   }
 
+  DocCounts* doc_counts = 0;
+  if(top_k > 0)
+  {
+    doc_counts = new DocCounts(*rlcsa, base_name);
+    doc_counts->reportSize(true);
+    if(!doc_counts->isOk())
+    {
+      delete rlcsa; rlcsa = 0;
+      delete adaptive_samples; adaptive_samples = 0;
+      delete run_samples; run_samples = 0;
+      delete doc_counts; doc_counts = 0;
+      return 5;
+    }
+  }
+
   std::ifstream pattern_file(patterns_name, std::ios_base::binary);
   if(!pattern_file)
   {
@@ -267,6 +326,8 @@ int main(int argc, char** argv)
     delete rlcsa; rlcsa = 0;
     delete sa; sa = 0;
     delete adaptive_samples; adaptive_samples = 0;
+    delete run_samples; run_samples = 0;
+    delete doc_counts; doc_counts = 0;
     return 6;
   }
   std::vector<std::string> rows;
@@ -279,6 +340,8 @@ int main(int argc, char** argv)
     delete rlcsa; rlcsa = 0;
     delete sa; sa = 0;
     delete adaptive_samples; adaptive_samples = 0;
+    delete run_samples; run_samples = 0;
+    delete doc_counts; doc_counts = 0;
     return 7;
   }
   std::vector<Pattern> patterns;
@@ -324,21 +387,28 @@ int main(int argc, char** argv)
 
 
   // Actual work.
+  usint listing_threads = 1;
   #ifdef MULTITHREAD_SUPPORT
   omp_set_num_threads(threads);
+  listing_threads = threads;
   #endif
   double start = readTimer();
 
-  #pragma omp parallel for schedule(dynamic, 1)
+  // With parallel listing, the patterns are processed one at a time.
+  #pragma omp parallel for schedule(dynamic, 1) if(!parallel_listing)
   for(usint i = 0; i < patterns.size(); i++)
   {
-    patterns[i].range = (use_sa ? sa->count(patterns[i].pattern) : rlcsa->count(patterns[i].pattern));
+    usint toehold = 0;
+    if(use_runs)    { patterns[i].range = run_samples->count(patterns[i].pattern, toehold); }
+    else if(use_sa) { patterns[i].range = sa->count(patterns[i].pattern); }
+    else            { patterns[i].range = rlcsa->count(patterns[i].pattern); }
 
     if(locate && patterns[i].found())
     {
       usint* matches = 0;
       uint* sa_matches = 0;
       if(adaptive)    { matches = adaptive_samples->locate(patterns[i].range, count_steps); }
+      else if(use_runs) { matches = run_samples->locate(patterns[i].range, toehold, count_steps); }
       else if(use_sa) { sa_matches = sa->locate(patterns[i].range); }
       else            { matches = rlcsa->locate(patterns[i].range, direct, count_steps); }
       if(count_steps)
@@ -361,13 +431,27 @@ int main(int argc, char** argv)
       delete[] sa_matches; sa_matches = 0;
       delete[] matches; matches = 0;
     }
+    if(top_k > 0 && patterns[i].found())
+    {
+      std::vector<pair_type>* docs = doc_counts->topK(patterns[i].range, top_k);
+      patterns[i].docc = docs->size();
+      delete docs; docs = 0;
+    }
     if(listing && patterns[i].found())
     {
       if(rle)
       {
-        std::vector<pair_type>* docs =
-          (direct ? docarray->directListingRLE(patterns[i].range)
-                  : docarray->listDocumentsRLE(patterns[i].range));
+        std::vector<pair_type>* docs = 0;
+        if(parallel_listing)
+        {
+          docs = (direct ? docarray->directListingRLE(patterns[i].range, listing_threads)
+                         : docarray->listDocumentsRLE(patterns[i].range, listing_threads));
+        }
+        else
+        {
+          docs = (direct ? docarray->directListingRLE(patterns[i].range)
+                         : docarray->listDocumentsRLE(patterns[i].range));
+        }
         if(docs != 0)
         {
           patterns[i].docc = 0;
@@ -380,9 +464,17 @@ int main(int argc, char** argv)
       }
       else
       {
-        std::vector<usint>* docs =
-          (direct ? docarray->directListing(patterns[i].range)
-                  : docarray->listDocuments(patterns[i].range));
+        std::vector<usint>* docs = 0;
+        if(parallel_listing)
+        {
+          docs = (direct ? docarray->directListing(patterns[i].range, listing_threads)
+                         : docarray->listDocuments(patterns[i].range, listing_threads));
+        }
+        else
+        {
+          docs = (direct ? docarray->directListing(patterns[i].range)
+                         : docarray->listDocuments(patterns[i].range));
+        }
         if(docs != 0)
         {
           patterns[i].docc = docs->size();
@@ -418,7 +510,7 @@ int main(int argc, char** argv)
     }
   }
   std::cout << std::endl;
-  if(listing)
+  if(listing || top_k > 0)
   {
     usint total_docc = totalDocc(patterns);
     std::cout << "Documents:     " << total_docc << " (" << (total_docc / seconds) << " / sec)" << std::endl;
@@ -466,10 +558,16 @@ int main(int argc, char** argv)
 
   // Cleanup.
 
-  if(adaptive) { adaptive_samples->report(); }
+  if(adaptive)
+  {
+    adaptive_samples->report();
+    if(write_adaptive) { adaptive_samples->writeTo(base_name); }
+  }
   delete rlcsa; rlcsa = 0;
   delete sa; sa = 0;
   delete adaptive_samples; adaptive_samples = 0;
+  delete run_samples; run_samples = 0;
+  delete doc_counts; doc_counts = 0;
   delete docarray; docarray = 0;
   delete[] totals; totals = 0;
   return 0;
@@ -481,13 +579,18 @@ printUsage()
 {
   std::cout << "Usage: rlcsa_test [options] base_name [patterns [threads]]" << std::endl;
   std::cout << "  -a   Use adaptive samples." << std::endl;
+  std::cout << "  -A   Write the learned adaptive samples (requires -a)." << std::endl;
   std::cout << "  -d   Use direct locate / document listing." << std::endl;
   std::cout << "  -g#  Use the weights to generate # actual patterns." << std::endl;
   std::cout << "  -i#  Ignore first # characters of each pattern." << std::endl;
   std::cout << "  -l   Locate the occurrences." << std::endl;
+  std::cout << "  -k#  Retrieve the # documents with the most occurrences (requires build_doc_counts)." << std::endl;
   std::cout << "  -L   List the documents containing the pattern." << std::endl;
+  std::cout << "  -m#  Memory policy for the index (0 = heap, 1 = huge pages, 2 = hugetlbfs; +4 = NUMA interleave)." << std::endl;
   std::cout << "  -o   Write the patterns sorted by occ/docc into patterns.sorted." << std::endl;
+  std::cout << "  -P   List the documents for one pattern at a time using all threads (requires -L)." << std::endl;
   std::cout << "  -p   Pattern file is in Pizza & Chili format." << std::endl;
+  std::cout << "  -R   Locate using run samples built by build_run_samples." << std::endl;
   std::cout << "  -r   Run-length encode the results (requires -L)." << std::endl;
   std::cout << "  -S   Use a plain suffix array (negates adaptive, direct, steps)." << std::endl;
   std::cout << "  -s   Count the number of steps required for locate() (negates write)." << std::endl;
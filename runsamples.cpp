@@ -0,0 +1,263 @@
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+#include "runsamples.h"
+#include "misc/utils.h"
+
+#ifdef MULTITHREAD_SUPPORT
+#include <omp.h>
+#endif
+
+
+namespace CSA
+{
+
+
+RunSamples::RunSamples(const RLCSA& _rlcsa, usint threads) :
+  rlcsa(_rlcsa),
+  run_ends(0), end_values(0), phi_keys(0), phi_values(0),
+  ok(false)
+{
+  if(!(this->rlcsa.isOk()) || !(this->rlcsa.supportsLocate()))
+  {
+    std::cerr << "RunSamples: Error: The index does not support locate!" << std::endl;
+    return;
+  }
+
+  // Determine the runs of Psi as closed ranges of SA indexes.
+  std::vector<pair_type> runs;
+  for(usint c = 0; c < CHARS; c++)
+  {
+    pair_type range = this->rlcsa.getCharRange(c);
+    if(isEmpty(range)) { continue; }
+    this->rlcsa.convertToSARange(range);
+    for(usint i = range.first; i <= range.second; )
+    {
+      pair_type run = this->rlcsa.psi(i, range.second - i);
+      runs.push_back(pair_type(i, i + run.second));
+      i += run.second + 1;
+    }
+  }
+
+  // Run ends are (SA index, SA value). Keys are (text position, phi value).
+  // A run start i gives key SA[i] + 1 with phi value SA[Psi(i) - 1], unless Psi(i)
+  // is an end marker.
+  usint text_size = this->rlcsa.getTextSize(), sequences = this->rlcsa.getNumberOfSequences();
+  std::vector<pair_type> ends(runs.size()), keys(runs.size());
+  #ifdef MULTITHREAD_SUPPORT
+  omp_set_num_threads(threads);
+  #endif
+  #pragma omp parallel for schedule(dynamic, 1)
+  for(usint i = 0; i < runs.size(); i++)
+  {
+    ends[i] = pair_type(runs[i].second, this->rlcsa.locate(runs[i].second));
+    usint next = this->rlcsa.psi(runs[i].first);
+    if(this->rlcsa.hasImplicitSample(next)) { keys[i] = pair_type(text_size, 0); }
+    else
+    {
+      keys[i] = pair_type(this->rlcsa.locate(runs[i].first) + 1, this->locateBWT(next - 1));
+    }
+  }
+  std::vector<pair_type>().swap(runs);
+
+  // Sequence starts are always keys.
+  for(usint i = 0; i < sequences; i++)
+  {
+    usint start = this->rlcsa.getSequenceRange(i).first;
+    usint bwt_index = this->rlcsa.inverseLocate(start);
+    this->rlcsa.convertToBWTIndex(bwt_index);
+    keys.push_back(pair_type(start, this->locateBWT(bwt_index - 1)));
+  }
+
+  this->build(ends, keys);
+}
+
+RunSamples::RunSamples(const RLCSA& _rlcsa, const std::string& base_name) :
+  rlcsa(_rlcsa),
+  run_ends(0), end_values(0), phi_keys(0), phi_values(0),
+  ok(false)
+{
+  std::string input_name = base_name + RUN_SAMPLES_EXTENSION;
+  std::ifstream input(input_name.c_str(), std::ios_base::binary);
+  if(!input)
+  {
+    std::cerr << "RunSamples: Error opening input file " << input_name << "!" << std::endl;
+    return;
+  }
+
+  usint value_bits = length(this->rlcsa.getTextSize());
+  this->run_ends = new DeltaVector(input);
+  this->end_values = new ReadBuffer(input, this->run_ends->getNumberOfItems(), value_bits);
+  this->phi_keys = new DeltaVector(input);
+  this->phi_values = new ReadBuffer(input, this->phi_keys->getNumberOfItems(), value_bits);
+  input.close();
+
+  if(this->run_ends->getSize() != this->rlcsa.getSize() || this->phi_keys->getSize() != this->rlcsa.getTextSize())
+  {
+    std::cerr << "RunSamples: Error: The samples do not match the index!" << std::endl;
+    return;
+  }
+  this->ok = true;
+}
+
+RunSamples::~RunSamples()
+{
+  delete this->run_ends; this->run_ends = 0;
+  delete this->end_values; this->end_values = 0;
+  delete this->phi_keys; this->phi_keys = 0;
+  delete this->phi_values; this->phi_values = 0;
+}
+
+void
+RunSamples::build(std::vector<pair_type>& ends, std::vector<pair_type>& keys)
+{
+  usint value_bits = length(this->rlcsa.getTextSize());
+
+  DeltaVector::Encoder end_encoder(INDEX_BLOCK_SIZE);
+  WriteBuffer end_buffer(ends.size(), value_bits);
+  for(usint i = 0; i < ends.size(); i++)
+  {
+    end_encoder.setBit(ends[i].first);
+    end_buffer.writeItem(ends[i].second);
+  }
+  std::vector<pair_type>().swap(ends);
+  this->run_ends = new DeltaVector(end_encoder, this->rlcsa.getSize());
+  this->end_values = end_buffer.getReadBuffer();
+
+  // The same key may come from a run start and a sequence start.
+  std::sort(keys.begin(), keys.end());
+  keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+  while(!(keys.empty()) && keys.back().first >= this->rlcsa.getTextSize()) { keys.pop_back(); }
+
+  DeltaVector::Encoder key_encoder(INDEX_BLOCK_SIZE);
+  WriteBuffer key_buffer(keys.size(), value_bits);
+  for(usint i = 0; i < keys.size(); i++)
+  {
+    key_encoder.setBit(keys[i].first);
+    key_buffer.writeItem(keys[i].second);
+  }
+  std::vector<pair_type>().swap(keys);
+  this->phi_keys = new DeltaVector(key_encoder, this->rlcsa.getTextSize());
+  this->phi_values = key_buffer.getReadBuffer();
+
+  this->ok = true;
+}
+
+//--------------------------------------------------------------------------
+
+void
+RunSamples::writeTo(const std::string& base_name) const
+{
+  if(!(this->isOk())) { return; }
+
+  std::string output_name = base_name + RUN_SAMPLES_EXTENSION;
+  std::ofstream output(output_name.c_str(), std::ios_base::binary);
+  if(!output)
+  {
+    std::cerr << "RunSamples: Error creating output file " << output_name << "!" << std::endl;
+    return;
+  }
+
+  this->run_ends->writeTo(output);
+  this->end_values->writeBuffer(output);
+  this->phi_keys->writeTo(output);
+  this->phi_values->writeBuffer(output);
+  output.close();
+}
+
+usint
+RunSamples::reportSize(bool print) const
+{
+  usint bytes = sizeof(*this);
+  usint end_bytes = 0, phi_bytes = 0;
+  if(this->isOk())
+  {
+    end_bytes = this->run_ends->reportSize() + this->end_values->reportSize();
+    phi_bytes = this->phi_keys->reportSize() + this->phi_values->reportSize();
+  }
+  bytes += end_bytes + phi_bytes;
+
+  if(print)
+  {
+    std::cout << "Run ends:        " << (end_bytes / (double)MEGABYTE) << " MB" << std::endl;
+    std::cout << "Phi samples:     " << (phi_bytes / (double)MEGABYTE) << " MB" << std::endl;
+    std::cout << "Total size:      " << (bytes / (double)MEGABYTE) << " MB" << std::endl;
+    std::cout << std::endl;
+  }
+
+  return bytes;
+}
+
+//--------------------------------------------------------------------------
+
+pair_type
+RunSamples::count(const std::string& pattern, usint& toehold) const
+{
+  toehold = 0;
+  if(pattern.length() == 0 || !(this->isOk())) { return EMPTY_PAIR; }
+
+  std::string::const_reverse_iterator iter = pattern.rbegin();
+  pair_type index_range = this->rlcsa.getCharRange((uchar)*iter);
+  if(isEmpty(index_range)) { return EMPTY_PAIR; }
+
+  // The last position of a character range is always a run end.
+  DeltaVector::Iterator end_iter(*(this->run_ends));
+  toehold = this->end_values->readItemConst(end_iter.rank(index_range.second - this->rlcsa.getNumberOfSequences()) - 1);
+
+  for(++iter; iter != pattern.rend(); ++iter)
+  {
+    usint prev_end = index_range.second;
+    index_range = this->rlcsa.LF(index_range, (uchar)*iter);
+    if(isEmpty(index_range)) { toehold = 0; return EMPTY_PAIR; }
+
+    // If BWT[prev_end] = c, the new toehold is the previous one minus 1.
+    // Otherwise the last occurrence of c before prev_end is the last position of a run.
+    usint sa_index = index_range.second; this->rlcsa.convertToSAIndex(sa_index);
+    if(this->rlcsa.psi(sa_index) == prev_end) { toehold--; }
+    else
+    {
+      toehold = this->end_values->readItemConst(end_iter.rank(sa_index) - 1);
+    }
+  }
+
+  this->rlcsa.convertToSARange(index_range);
+  return index_range;
+}
+
+usint*
+RunSamples::locate(pair_type range, usint toehold, bool steps) const
+{
+  if(isEmpty(range) || !(this->isOk())) { return 0; }
+
+  usint* data = new usint[length(range)];
+  data[length(range) - 1] = (steps ? 0 : toehold);
+  for(usint i = length(range) - 1; i > 0; i--)
+  {
+    toehold = this->phi(toehold);
+    data[i - 1] = (steps ? 1 : toehold);
+  }
+
+  return data;
+}
+
+usint
+RunSamples::phi(usint value) const
+{
+  DeltaVector::Iterator iter(*(this->phi_keys));
+  pair_type key = iter.valueBefore(value);
+  return this->phi_values->readItemConst(key.second) + (value - key.first);
+}
+
+//--------------------------------------------------------------------------
+
+usint
+RunSamples::locateBWT(usint bwt_index) const
+{
+  if(this->rlcsa.hasImplicitSample(bwt_index)) { return this->rlcsa.getImplicitSample(bwt_index); }
+  this->rlcsa.convertToSAIndex(bwt_index);
+  return this->rlcsa.locate(bwt_index);
+}
+
+
+} // namespace CSA
@@ -0,0 +1,84 @@
+#ifndef RUNSAMPLES_H
+#define RUNSAMPLES_H
+
+#include <fstream>
+
+#include "rlcsa.h"
+#include "bits/bitbuffer.h"
+#include "bits/deltavector.h"
+
+
+namespace CSA
+{
+
+
+const std::string RUN_SAMPLES_EXTENSION = ".rlcsa.run_samples";
+
+
+/*
+  Run-boundary samples in the style of the r-index (Gagie, Navarro, Prezza: Optimal-time
+  text indexing in BWT-runs bounded space, SODA 2018), adapted to Psi runs.
+
+  We store SA[i] for the last position i of each run of Psi, and the function
+  phi(SA[i]) = SA[i - 1] at the positions that follow the first positions of the runs
+  and at the sequence starts. Backward search tracks SA[sp..ep] through the toehold
+  SA[ep], and the rest of the occurrences are found with phi in O(1) predecessor
+  queries each. The space is proportional to the number of runs instead of n / sample_rate.
+
+  The samples are built from an index that supports locate, but queries only need Psi.
+*/
+
+class RunSamples
+{
+  public:
+    const static usint INDEX_BLOCK_SIZE = 16;
+
+    // Builds the samples using the regular samples of the index.
+    RunSamples(const RLCSA& _rlcsa, usint threads);
+    RunSamples(const RLCSA& _rlcsa, const std::string& base_name);
+    ~RunSamples();
+
+    void writeTo(const std::string& base_name) const;
+    usint reportSize(bool print = false) const;
+
+    // Returns the SA range of the pattern and writes SA[range.second] into toehold.
+    pair_type count(const std::string& pattern, usint& toehold) const;
+
+    // Returns SA[range], when toehold is SA[range.second]. User must free the buffer.
+    // Steps means that the returned values are the number of phi steps taken, not SA values.
+    usint* locate(pair_type range, usint toehold, bool steps = false) const;
+
+    // Returns the SA value of the suffix preceding the suffix at text position value.
+    // The value must be a text position of a suffix that is not the first one in SA.
+    usint phi(usint value) const;
+
+    inline bool isOk() const { return this->ok; }
+    inline usint getNumberOfRuns() const { return this->run_ends->getNumberOfItems(); }
+    inline usint getNumberOfKeys() const { return this->phi_keys->getNumberOfItems(); }
+
+  private:
+    const RLCSA& rlcsa;
+
+    DeltaVector* run_ends;    // SA indexes of the last positions of Psi runs.
+    ReadBuffer*  end_values;  // SA values at the run ends.
+    DeltaVector* phi_keys;    // Text positions where phi is not phi(value - 1) + 1.
+    ReadBuffer*  phi_values;  // Phi at the keys.
+
+    bool ok;
+
+    // Returns SA[bwt_index] for a BWT index, including the end markers.
+    usint locateBWT(usint bwt_index) const;
+
+    void build(std::vector<pair_type>& ends, std::vector<pair_type>& keys);
+
+    // These are not allowed.
+    RunSamples();
+    RunSamples(const RunSamples&);
+    RunSamples& operator = (const RunSamples&);
+};
+
+
+} // namespace CSA
+
+
+#endif // RUNSAMPLES_H
@@ -0,0 +1,104 @@
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+#include "saextractor.h"
+
+#ifdef MULTITHREAD_SUPPORT
+#include <omp.h>
+#endif
+
+
+namespace CSA
+{
+
+
+SAExtractor::SAExtractor(const RLCSA& _rlcsa, const PLCPVector* _plcp, usint _block_size, usint _threads) :
+  rlcsa(_rlcsa), plcp(_plcp),
+  block_size(std::max(_block_size, (usint)1)), threads(std::max(_threads, (usint)1)),
+  sa(0), da(0), lcp(0),
+  batch_start(0), next_start(0), blocks(0), current(0), range(EMPTY_PAIR),
+  ok(false)
+{
+  if(!(this->rlcsa.isOk()) || !(this->rlcsa.supportsLocate()))
+  {
+    std::cerr << "SAExtractor: Error: The index does not support locate!" << std::endl;
+    return;
+  }
+
+  usint buffer_size = this->threads * this->block_size;
+  this->sa = new usint[buffer_size];
+  this->da = new usint[buffer_size];
+  if(this->plcp != 0) { this->lcp = new usint[buffer_size]; }
+  this->ok = true;
+}
+
+SAExtractor::~SAExtractor()
+{
+  delete[] this->sa; this->sa = 0;
+  delete[] this->da; this->da = 0;
+  delete[] this->lcp; this->lcp = 0;
+}
+
+bool
+SAExtractor::next()
+{
+  if(!(this->isOk())) { return false; }
+
+  if(this->current + 1 < this->blocks) { this->current++; }
+  else if(!(this->extractBatch())) { this->range = EMPTY_PAIR; return false; }
+
+  usint start = this->batch_start + this->current * this->block_size;
+  this->range = pair_type(start, std::min(start + this->block_size, this->rlcsa.getSize()) - 1);
+  return true;
+}
+
+void
+SAExtractor::reset()
+{
+  this->batch_start = this->next_start = 0;
+  this->blocks = this->current = 0;
+  this->range = EMPTY_PAIR;
+}
+
+//--------------------------------------------------------------------------
+
+bool
+SAExtractor::extractBatch()
+{
+  usint n = this->rlcsa.getSize();
+  if(this->next_start >= n) { this->blocks = this->current = 0; return false; }
+
+  this->blocks = std::min(this->threads, (n - this->next_start + this->block_size - 1) / this->block_size);
+  this->current = 0;
+
+  #ifdef MULTITHREAD_SUPPORT
+  omp_set_num_threads(this->threads);
+  #endif
+  #pragma omp parallel for schedule(dynamic, 1)
+  for(usint block = 0; block < this->blocks; block++)
+  {
+    usint start = this->next_start + block * this->block_size;
+    pair_type block_range(start, std::min(start + this->block_size, n) - 1);
+    usint offset = block * this->block_size, len = length(block_range);
+
+    usint* block_sa = this->sa + offset;
+    this->rlcsa.locate(block_range, block_sa);
+    if(this->plcp != 0)
+    {
+      PLCPVector::Iterator iter(*(this->plcp));
+      usint* block_lcp = this->lcp + offset;
+      for(usint i = 0; i < len; i++) { block_lcp[i] = iter.select(block_sa[i]) - 2 * block_sa[i]; }
+    }
+    usint* block_da = this->da + offset;
+    std::memcpy(block_da, block_sa, len * sizeof(usint));
+    this->rlcsa.getSequenceForPosition(block_da, len);
+  }
+
+  this->batch_start = this->next_start;
+  this->next_start = std::min(this->next_start + this->blocks * this->block_size, n);
+  return true;
+}
+
+
+} // namespace CSA
@@ -0,0 +1,85 @@
+#ifndef SAEXTRACTOR_H
+#define SAEXTRACTOR_H
+
+#include "rlcsa.h"
+
+
+namespace CSA
+{
+
+
+/*
+  Streams SA[i], DA[i] = getSequenceForPosition(SA[i]), and LCP[i] = PLCP[SA[i]] in SA
+  order, one block of block_size positions at a time. The blocks are extracted in
+  batches of 'threads' blocks, each block by a separate thread, so the memory usage is
+  3 * threads * block_size integers instead of full arrays.
+
+  LCP[i] is the length of the longest common prefix of suffixes i - 1 and i, and
+  LCP[0] = 0. If plcp is 0, LCP values are not extracted.
+
+  Usage:
+    SAExtractor extractor(rlcsa, plcp, block_size, threads);
+    while(extractor.next())
+    {
+      for(usint i = 0; i < extractor.getBlockLength(); i++)
+      {
+        // Position extractor.getRange().first + i: getSA()[i], getDA()[i], getLCP()[i].
+      }
+    }
+*/
+
+class SAExtractor
+{
+  public:
+    const static usint DEFAULT_BLOCK_SIZE = MEGABYTE;
+
+    // The index must support locate. plcp is not owned by the extractor.
+    SAExtractor(const RLCSA& _rlcsa, const PLCPVector* _plcp, usint _block_size, usint _threads);
+    ~SAExtractor();
+
+    // Moves to the next block. Returns false when the entire suffix array has been extracted.
+    bool next();
+
+    // Starts again from the beginning of the suffix array.
+    void reset();
+
+    inline bool isOk() const { return this->ok; }
+
+    // SA range of the current block.
+    inline pair_type getRange() const { return this->range; }
+    inline usint getBlockLength() const { return length(this->range); }
+
+    inline const usint* getSA() const { return this->sa + this->current * this->block_size; }
+    inline const usint* getDA() const { return this->da + this->current * this->block_size; }
+    inline const usint* getLCP() const
+    {
+      return (this->lcp == 0 ? 0 : this->lcp + this->current * this->block_size);
+    }
+
+  private:
+    const RLCSA&      rlcsa;
+    const PLCPVector* plcp;
+    usint             block_size, threads;
+
+    usint* sa;
+    usint* da;
+    usint* lcp;
+
+    usint     batch_start, next_start;  // First SA indexes of the current and the next batch.
+    usint     blocks, current;          // Blocks in the current batch, current block.
+    pair_type range;
+    bool      ok;
+
+    bool extractBatch();
+
+    // These are not allowed.
+    SAExtractor();
+    SAExtractor(const SAExtractor&);
+    SAExtractor& operator = (const SAExtractor&);
+};
+
+
+} // namespace CSA
+
+
+#endif // SAEXTRACTOR_H
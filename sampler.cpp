@@ -3,6 +3,7 @@
 #include <fstream>
 #include <iostream>
 #include <limits>
+#include <vector>
 
 #ifdef MULTITHREAD_SUPPORT
 #include <omp.h>
@@ -63,11 +64,55 @@ Sampler::getSamples(short_pair* sa, uint number_of_sequences, usint threads)
   return result;
 }
 
+bool
+Sampler::writeSamples(const RLCSA& index, const std::string& base_name, usint threads) const
+{
+  if(this->samples == 0 || this->status != SAMPLED) { return false; }
+  if(!(index.supportsLocate()) || index.getNumberOfSequences() != 1 || index.getSize() != this->size)
+  {
+    std::cerr << "Sampler: The samples do not match the index!" << std::endl;
+    return false;
+  }
+
+  pair_type* sample_pairs = new pair_type[this->number_of_samples];
+  #ifdef MULTITHREAD_SUPPORT
+  omp_set_num_threads(threads);
+  #endif
+  #pragma omp parallel for schedule(dynamic, 1024)
+  for(uint i = 0; i < this->number_of_samples; i++)
+  {
+    sample_pairs[i].first = index.inverseLocate(this->samples[i].second);
+    sample_pairs[i].second = this->samples[i].second;
+  }
+
+  std::string sample_name = base_name + SA_SAMPLES_EXTENSION;
+  std::ofstream sample_file(sample_name.c_str(), std::ios_base::binary);
+  if(!sample_file)
+  {
+    std::cerr << "Sampler: Error creating sample file!" << std::endl;
+    delete[] sample_pairs;
+    return false;
+  }
+  usint data_size = this->size, items = this->number_of_samples;
+  sample_file.write((char*)&data_size, sizeof(data_size));
+  sample_file.write((char*)&items, sizeof(items));
+  sample_file.write((char*)sample_pairs, items * sizeof(pair_type));
+  sample_file.close();
+  delete[] sample_pairs;
+
+  Parameters parameters;
+  parameters.read(base_name + PARAMETERS_EXTENSION);
+  parameters.set(WEIGHTED_SAMPLES.first, 1);
+  parameters.write(base_name + PARAMETERS_EXTENSION);
+
+  return true;
+}
+
 //--------------------------------------------------------------------------
 
-WeightedSampler::WeightedSampler(weight_type* weights, uint _size, bool _use_psi) :
+WeightedSampler::WeightedSampler(weight_type* weights, uint _size, bool _use_psi, bool _verbose) :
   Sampler(_size),
-  use_psi(_use_psi), adjustment(0),
+  use_psi(_use_psi), verbose(_verbose), adjustment(0),
   path_weights(0), predecessors(0),
   edge_weights(0), edge_totals(0),
   nodes(0), node_positions(0)
@@ -139,13 +184,13 @@ WeightedSampler::buildSamples(uint sample_rate, sum_type initial_adjustment, usi
   // With adjustment 0, we can always find a path of weight 0: just take as many edges as
   // possible. Hence adjustment 0 will be used only when we can afford to sample every
   // suffix with a positive weight. This is equivalent to greedy sampling.
-  std::cout << "left: " << left << ", right: " << right << std::endl;
+  if(this->verbose) { std::cout << "left: " << left << ", right: " << right << std::endl; }
   while(true)
   {
-    std::cout << "Adjustment: " << this->adjustment << std::endl;
+    if(this->verbose) { std::cout << "Adjustment: " << this->adjustment << std::endl; }
 
     shortest = this->minimumWeightPath(true, force);
-    std::cout << "  shortest: " << shortest << " (weight " << this->path_weights[this->nodes - 1] << ")" << std::endl;
+    if(this->verbose) { std::cout << "  shortest: " << shortest << " (weight " << this->path_weights[this->nodes - 1] << ")" << std::endl; }
     if(shortest > this->number_of_samples)
     {
       left = this->adjustment + 1;
@@ -159,7 +204,7 @@ WeightedSampler::buildSamples(uint sample_rate, sum_type initial_adjustment, usi
     }
 
     longest = this->minimumWeightPath(false, force);
-    std::cout << "  longest:  " << longest << " (weight " << this->path_weights[this->nodes - 1] << ")" << std::endl;
+    if(this->verbose) { std::cout << "  longest:  " << longest << " (weight " << this->path_weights[this->nodes - 1] << ")" << std::endl; }
     if(longest < this->number_of_samples && this->adjustment > 1) // If adjustment will still be >= 1.
     {
       right = this->adjustment - 1;
@@ -175,7 +220,7 @@ WeightedSampler::buildSamples(uint sample_rate, sum_type initial_adjustment, usi
 
     break;
   }
-  std::cout << std::endl;
+  if(this->verbose) { std::cout << std::endl; }
   this->cleanUp();
 
   // Build a 'number'-link path from the saved paths.
@@ -463,6 +508,78 @@ WeightedSampler::isAsGood(uint a, uint b)
 
 //--------------------------------------------------------------------------
 
+SegmentedSampler::SegmentedSampler(weight_type* _weights, uint _size, bool _use_psi) :
+  Sampler(_size),
+  weights(_weights), use_psi(_use_psi)
+{
+  if(this->weights == 0 || this->size == 0)
+  {
+    this->cleanUp(); return;
+  }
+  this->status = READY;
+}
+
+SegmentedSampler::~SegmentedSampler()
+{
+  this->cleanUp();
+}
+
+void
+SegmentedSampler::cleanUp()
+{
+  delete[] this->weights; this->weights = 0;
+}
+
+bool
+SegmentedSampler::buildSamples(uint sample_rate, uint segment_length, usint threads)
+{
+  if(sample_rate == 0 || segment_length == 0 || this->status != READY) { return false; }
+
+  segment_length = sample_rate * ((segment_length + sample_rate - 1) / sample_rate);
+  uint segments = (this->size + segment_length - 1) / segment_length;
+  std::vector<WeightedSampler*> samplers(segments, (WeightedSampler*)0);
+  bool ok = true;
+
+  #ifdef MULTITHREAD_SUPPORT
+  omp_set_num_threads(threads);
+  #endif
+  #pragma omp parallel for schedule(dynamic, 1)
+  for(uint i = 0; i < segments; i++)
+  {
+    uint start = i * segment_length, len = std::min(segment_length, this->size - start);
+    weight_type* segment_weights = new weight_type[len];
+    for(uint j = 0; j < len; j++) { segment_weights[j] = this->weights[start + j]; }
+    samplers[i] = new WeightedSampler(segment_weights, len, this->use_psi, false);
+    if(!(samplers[i]->buildSamples(sample_rate, 0, 1)))
+    {
+      #pragma omp critical
+      ok = false;
+    }
+  }
+  this->cleanUp();
+
+  if(ok)
+  {
+    this->number_of_samples = 0;
+    for(uint i = 0; i < segments; i++) { this->number_of_samples += samplers[i]->getItems(); }
+    this->samples = new pair_type[this->number_of_samples];
+    for(uint i = 0, k = 0; i < segments; i++)
+    {
+      for(uint j = 0; j < samplers[i]->getItems(); j++, k++)
+      {
+        this->samples[k].second = i * segment_length + samplers[i]->getPosition(j);
+      }
+    }
+    this->status = SAMPLED;
+  }
+  else { this->status = NOT_READY; }
+
+  for(uint i = 0; i < segments; i++) { delete samplers[i]; }
+  return ok;
+}
+
+//--------------------------------------------------------------------------
+
 SemiGreedySampler::SemiGreedySampler(weight_type* _weights, uint _size) :
   Sampler(_size),
   weights(0),
@@ -11,6 +11,8 @@ namespace CSA
 {
 
 
+class RLCSA;
+
 typedef uint  weight_type;
 typedef usint sum_type;
 
@@ -30,6 +32,11 @@ class Sampler
     // The user must delete the samples.
     pair_type* getSamples(short_pair* sa, uint number_of_sequences, usint threads);
 
+    // Writes the samples as weighted samples of an existing single-sequence index, and
+    // sets WEIGHTED_SAMPLES in its parameter file. The SA indexes are determined with
+    // inverseLocate(), so the index must support locate. Returns 'true' if ok.
+    bool writeSamples(const RLCSA& index, const std::string& base_name, usint threads) const;
+
     const static uint NOT_READY = 0;
     const static uint READY = 1;
     const static uint SAMPLED = 2;
@@ -38,6 +45,9 @@ class Sampler
     inline uint getSize() const { return this->size; }
     inline uint getItems() const { return this->number_of_samples; }
 
+    // Returns the text position of the ith sample. Requires status SAMPLED.
+    inline uint getPosition(uint i) const { return this->samples[i].second; }
+
   protected:
     uint size, status;
 
@@ -56,7 +66,8 @@ class WeightedSampler : public Sampler
   public:
     // We assume that weights are non-negative.
     // 'weights' will be deleted in the constructor.
-    WeightedSampler(weight_type* weights, uint _size, bool _use_psi);
+    // If 'verbose' is false, buildSamples() does not print the progress of the search.
+    WeightedSampler(weight_type* weights, uint _size, bool _use_psi, bool _verbose = true);
     virtual ~WeightedSampler();
 
     // Call this to build the samples. Returns 'true' if ok.
@@ -66,7 +77,7 @@ class WeightedSampler : public Sampler
   private:
     const static usint VECTOR_BLOCK_SIZE = 64;
 
-    bool      use_psi;
+    bool      use_psi, verbose;
     sum_type  adjustment;
 
     sum_type* path_weights;
@@ -132,6 +143,38 @@ class WeightedSampler : public Sampler
 };
 
 
+/*
+  Splits the text into segments and samples each segment independently with
+  WeightedSampler. The segments are processed in parallel without synchronization,
+  and each segment starts with a forced sample. Each segment gets n / d samples for
+  its own length n, so the result can be slightly worse than with WeightedSampler.
+*/
+
+class SegmentedSampler : public Sampler
+{
+  public:
+    // We assume that weights are non-negative.
+    // 'weights' will be deleted in buildSamples() or in the destructor.
+    SegmentedSampler(weight_type* weights, uint _size, bool _use_psi);
+    virtual ~SegmentedSampler();
+
+    // Call this to build the samples. Returns 'true' if ok.
+    // Segment length is rounded up to a multiple of sample rate.
+    bool buildSamples(uint sample_rate, uint segment_length, usint threads);
+
+  private:
+    weight_type* weights;
+    bool         use_psi;
+
+    void cleanUp();
+
+    // These are not allowed.
+    SegmentedSampler();
+    SegmentedSampler(const SegmentedSampler&);
+    SegmentedSampler& operator = (const SegmentedSampler&);
+};
+
+
 class SemiGreedySampler : public Sampler
 {
   public:
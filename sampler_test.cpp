@@ -20,6 +20,7 @@ printUsage()
   std::cout << "  -b   Use backward edge weights (locate for LF, display for Psi)." << std::endl;
   std::cout << "  -g#  Select # (float) part of samples greedily, and the rest at regular intervals." << std::endl;
   std::cout << "  -m#  Multiply weights by # (float)." << std::endl;
+  std::cout << "  -s#  Sample segments of # positions independently in parallel." << std::endl;
   std::cout << "  -t#  Use # threads." << std::endl;
   std::cout << "  -w   Write the sampled positions into sample file." << std::endl;
 }
@@ -36,7 +37,7 @@ int main(int argc, char** argv)
   bool greedy = false, forward = true, write = false;
   char* base_name = 0;
   char* weights_name = 0;
-  usint threads = 1;
+  usint threads = 1, segment_length = 0;
   for(int i = 1; i < argc; i++)
   {
     if(argv[i][0] == '-')
@@ -49,6 +50,8 @@ int main(int argc, char** argv)
           greediness = atof(argv[i] + 2); greedy = true; break;
         case 'm':
           multiplier = atof(argv[i] + 2); break;
+        case 's':
+          segment_length = atoi(argv[i] + 2); break;
         case 't':
           threads = atoi(argv[i] + 2); break;
         case 'w':
@@ -77,6 +80,7 @@ int main(int argc, char** argv)
   if(greedy) { std::cout << " greediness=" << greediness; }
   if(multiplier < 0) { multiplier = 1.0; }
   if(multiplier != 1.0) { std::cout << " multiplier=" << multiplier; }
+  if(segment_length > 0 && !greedy) { std::cout << " segments=" << segment_length; }
   std::cout << " threads=" << threads;
   if(write) { std::cout << " write"; }
   std::cout << std::endl;
@@ -128,7 +132,17 @@ int main(int argc, char** argv)
   // Do the actual sampling.
   double start = readTimer();
   Sampler* sampler = 0;
-  if(!greedy)
+  if(!greedy && segment_length > 0)
+  {
+    SegmentedSampler* ssampler = new SegmentedSampler(weights, n, forward);
+    if(!(ssampler->buildSamples(parameters.get(SAMPLE_RATE), segment_length, threads)))
+    {
+      delete ssampler; ssampler = 0;
+      return 5;
+    }
+    sampler = ssampler; ssampler = 0;
+  }
+  else if(!greedy)
   {
     WeightedSampler* wsampler = new WeightedSampler(weights, n, forward);
     if(!(wsampler->buildSamples(parameters.get(SAMPLE_RATE), parameters.get(INITIAL_ADJUSTMENT), threads)))
@@ -19,7 +19,7 @@ namespace CSA
 //--------------------------------------------------------------------------
 
 SASamples::SASamples(std::ifstream& sample_file, usint sample_rate, bool _weighted) :
-  weighted(_weighted)
+  weighted(_weighted), direct_inverse(true)
 {
   if(this->weighted)
   {
@@ -45,7 +45,7 @@ SASamples::SASamples(std::ifstream& sample_file, usint sample_rate, bool _weight
 }
 
 SASamples::SASamples(FILE* sample_file, usint sample_rate, bool _weighted) :
-  weighted(_weighted)
+  weighted(_weighted), direct_inverse(true)
 {
   if(sample_file == 0) { return; }
 
@@ -72,14 +72,14 @@ SASamples::SASamples(FILE* sample_file, usint sample_rate, bool _weighted) :
   }
 }
 
-SASamples::SASamples(short_pair* sa, DeltaVector* end_points, usint data_size, usint sample_rate, usint threads) :
-  weighted(false),
+SASamples::SASamples(short_pair* sa, EndPointVector* end_points, usint data_size, usint sample_rate, usint threads) :
+  weighted(false), direct_inverse(true),
   rate(sample_rate),
   items(0)
 {
   usint sequences = end_points->getNumberOfItems();
 
-  DeltaVector::Iterator iter(*(end_points));
+  EndPointVector::Iterator iter(*(end_points));
 
   // Determine the samples, insert them into a vector, and sort them.
   usint start = 0, end = iter.select(0);  // Closed range in padded collection.
@@ -120,7 +120,7 @@ SASamples::SASamples(short_pair* sa, DeltaVector* end_points, usint data_size, u
 }
 
 SASamples::SASamples(short_pair* sa, Sampler* sampler, usint threads) :
-  weighted(true),
+  weighted(true), direct_inverse(true),
   rate(1), size(sampler->getSize()), items(sampler->getItems())
 {
   pair_type* sample_pairs = sampler->getSamples(sa, 1, threads); // FIXME multiple sequences?
@@ -130,7 +130,7 @@ SASamples::SASamples(short_pair* sa, Sampler* sampler, usint threads) :
 }
 
 SASamples::SASamples(pair_type* sample_pairs, usint data_size, usint sample_rate, usint threads) :
-  weighted(false),
+  weighted(false), direct_inverse(true),
   rate(sample_rate), size(data_size), items((data_size + sample_rate - 1) / sample_rate)
 {
   #ifdef MULTITHREAD_SUPPORT
@@ -153,7 +153,7 @@ SASamples::SASamples(pair_type* sample_pairs, usint data_size, usint sample_rate
 }
 
 SASamples::SASamples(SASamples& index, SASamples& increment, usint* positions, usint number_of_positions, usint number_of_sequences) :
-  weighted(false),
+  weighted(false), direct_inverse(true),
   rate(index.rate),
   size(index.size + increment.size),
   items(index.items + increment.items)
@@ -244,10 +244,17 @@ SASamples::inverseSA(usint value) const
   if(this->weighted)
   {
     SAVector::Iterator iter(*(this->inverse_indexes));
-    result.first = iter.rank(value) - 1;
+    result.first = iter.rank(value);
+    if(result.first == 0) { return pair_type(this->size, this->size); }
+    result.first--;
     result.second = this->inverse_samples->readItemConst(result.first);
     result.first = iter.select(result.first);
   }
+  else if(this->direct_inverse)
+  {
+    result.first = value - (value % this->rate);
+    result.second = this->inverse_samples->readItemConst(value / this->rate);
+  }
   else
   {
     SAVector::Iterator iter(*(this->indexes));
@@ -260,9 +267,38 @@ SASamples::inverseSA(usint value) const
 
 //--------------------------------------------------------------------------
 
+void
+SASamples::setDirectInverse(bool direct)
+{
+  if(this->weighted || direct == this->direct_inverse) { return; }
+  this->direct_inverse = direct;
+  if(this->inverse_samples != 0)
+  {
+    delete this->inverse_samples; this->inverse_samples = 0;
+    this->buildInverseSamples();
+  }
+}
+
 void
 SASamples::buildInverseSamples()
 {
+  this->inverse_indexes = 0;
+  if(this->direct_inverse)
+  {
+    // Store the SA indexes instead of sample numbers, so that inverseSA() does not need select.
+    WriteBuffer inverse_buffer(this->items, length(this->size - 1));
+    SAVector::Iterator iter(*(this->indexes));
+    this->samples->goToItem(0);
+    for(usint i = 0; i < this->items; i++)
+    {
+      usint index = (i == 0 ? iter.select(0) : iter.selectNext());
+      inverse_buffer.goToItem(this->samples->readItem());
+      inverse_buffer.writeItem(index);
+    }
+    this->inverse_samples = inverse_buffer.getReadBuffer();
+    return;
+  }
+
   WriteBuffer inverse_buffer(this->items, length(this->items - 1));
   this->samples->goToItem(0);
   for(usint i = 0; i < this->items; i++)
@@ -270,8 +306,6 @@ SASamples::buildInverseSamples()
     inverse_buffer.goToItem(this->samples->readItem());
     inverse_buffer.writeItem(i);
   }
-
-  this->inverse_indexes = 0;
   this->inverse_samples = inverse_buffer.getReadBuffer();
 }
 
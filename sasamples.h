@@ -14,16 +14,29 @@
 #include "bits/succinctvector.h"
 #endif
 
+#if defined(ELIAS_FANO_SA_VECTOR) || defined(ELIAS_FANO_END_POINTS)
+#include "bits/eliasfanovector.h"
+#endif
+
 namespace CSA
 {
 
 
 #ifdef SUCCINCT_SA_VECTOR
 typedef SuccinctVector SAVector;
+#elif defined(ELIAS_FANO_SA_VECTOR)
+typedef EliasFanoVector SAVector;
 #else
 typedef DeltaVector SAVector;
 #endif
 
+// Sequence end points in RLCSA.
+#ifdef ELIAS_FANO_END_POINTS
+typedef EliasFanoVector EndPointVector;
+#else
+typedef DeltaVector EndPointVector;
+#endif
+
 
 class SASamples
 {
@@ -38,7 +51,7 @@ class SASamples
     SASamples(FILE* sample_file, usint sample_rate, bool _weighted);
 
     // These assume < 4 GB data.
-    SASamples(short_pair* sa, DeltaVector* end_points, usint data_size, usint sample_rate, usint threads);
+    SASamples(short_pair* sa, EndPointVector* end_points, usint data_size, usint sample_rate, usint threads);
     SASamples(short_pair* sa, Sampler* sampler, usint threads); // Use the given samples.
 
     // Use these samples. Assumes regular sampling.
@@ -58,7 +71,7 @@ class SASamples
     // Returns (i, inverseSA(i)) such that i is the last sampled position up to value.
     // The return value can also be thought of as (SA[j], j).
     // Value is actual 0-based suffix array value.
-    // Returns (size, size) if value is too large.
+    // Returns (size, size) if value is too large or there is no sample at or before it.
     pair_type inverseSA(usint value) const;
 
     // Returns the value of ith sample in suffix array order.
@@ -89,6 +102,11 @@ class SASamples
     inline usint getSampleRate() const { return this->rate; }
     inline usint getNumberOfSamples() const { return this->items; }
 
+    // Regular samples store the inverse samples either as SA indexes (direct, the default),
+    // or as sample numbers that need a select in inverseSA(). Weighted samples are not affected.
+    void setDirectInverse(bool direct);
+    inline bool hasDirectInverse() const { return (!(this->weighted) && this->direct_inverse); }
+
     inline bool isWeighted() const { return this->weighted; }
     inline bool supportsLocate() const { return (this->samples != 0); }
     inline bool supportsDisplay() const { return (this->inverse_samples != 0); }
@@ -99,7 +117,7 @@ class SASamples
     void strip();
 
   private:
-    bool weighted;
+    bool weighted, direct_inverse;
     usint rate, size, items;
 
     SAVector*   indexes;